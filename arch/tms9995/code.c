@@ -64,17 +64,18 @@ setseg(int seg, char *name)
 	case DATA:
 	case LDATA: name = ".data"; break;
 	case UDATA: break;
+	case NMSEG: break;
 	default:
 		cerror("setseg");
 	}
-	printf("\t%s\n", name);
+	printf(PRTPREF "\t%s\n", name);
 }
 
 void
 defalign(int al)
 {
 	if (al > ALCHAR)
-		printf(".even\n");
+		printf(PRTPREF ".even\n");
 }
 
 /*
@@ -91,16 +92,21 @@ defloc(struct symtab *sp)
 
 	t = sp->stype;
 	s = ISFTN(t) ? PROG : ISCON(cqual(t, sp->squal)) ? RDATA : DATA;
+#ifdef GCC_COMPAT
+	/* locctr() already switched to the named section */
+	if (attr_find(sp->sap, GCC_ATYP_SECTION) != NULL)
+		s = lastloc;
+#endif
 	if (s != lastloc)
-		printf("	.%s\n", loctbl[s]);
+		printf(PRTPREF "	.%s\n", loctbl[s]);
 	lastloc = s;
 	n = getexname(sp);
 	if (sp->sclass == EXTDEF)
-		printf("	.export %s\n", n);
+		printf(PRTPREF "	.export %s\n", n);
 	if (sp->slevel == 0) {
-		printf("%s:\n", n);
+		printf(PRTPREF "%s:\n", n);
 	} else {
-		printf(LABFMT ":\n", sp->soffset);
+		printf(PRTPREF LABFMT ":\n", sp->soffset);
 	}
 }
 
@@ -131,6 +137,7 @@ efcode(void)
 	/* create struct assignment */
 	q = nametree(sp);
 	p = block(REG, NIL, NIL, PTR+STRTY, 0, cftnsp->sap);
+	p->n_rval = RETREG(PTR+STRTY);
 	p = buildtree(UMUL, p, NIL);
 	p = buildtree(ASSIGN, q, p);
 	ecomp(p);
@@ -138,6 +145,7 @@ efcode(void)
 	/* return address of buffer */
 	q = buildtree(ADDROF, nametree(sp), NIL);
 	p = block(REG, NIL, NIL, PTR+STRTY, 0, cftnsp->sap);
+	p->n_rval = RETREG(PTR+STRTY);
 	p = buildtree(ASSIGN, p, q);
 	ecomp(p);
 }
@@ -245,6 +253,9 @@ bfcode(struct symtab **sp, int cnt)
 
 	/* recalculate the arg offset and create TEMP moves */
 	for (i = 0; i < cnt; i++) {
+		/* Structs are always on the stack, as are any args after */
+		if (ISSOU(sp[i]->stype))
+			reg_arg_end();
 		if ((n = reg_arg_alloc(sp[i]->stype)) != 0) {
 			p = tempnode(0, sp[i]->stype, sp[i]->sdf, sp[i]->sap);
 			q = block(REG, NIL, NIL,
@@ -267,7 +278,7 @@ bfcode(struct symtab **sp, int cnt)
 			   rules), which means the value is 1 byte further in */
 			if (sp[i]->stype == CHAR || sp[i]->stype == UCHAR)
 				sp[i]->soffset += SZCHAR;
-			if (xtemps) {
+			if (xtemps && !ISSOU(sp[i]->stype)) {
 				/* put stack args in temps if optimizing */
 				p = tempnode(0, sp[i]->stype,
 				    sp[i]->sdf, sp[i]->sap);
@@ -287,14 +298,14 @@ void
 ejobcode(int flag)
 {
 	/* Make sure the object module is even aligned */
-	printf("	.code\n");
-	printf("	.even\n");
-	printf("	.data\n");
-	printf("	.even\n");
-	printf("	.bss\n");
-	printf("	.even\n");
-	printf("	.discard\n");
-	printf("	.even\n");
+	printf(PRTPREF "	.code\n");
+	printf(PRTPREF "	.even\n");
+	printf(PRTPREF "	.data\n");
+	printf(PRTPREF "	.even\n");
+	printf(PRTPREF "	.bss\n");
+	printf(PRTPREF "	.even\n");
+	printf(PRTPREF "	.discard\n");
+	printf(PRTPREF "	.even\n");
 }
 
 void
@@ -382,6 +393,101 @@ funcode(NODE *p)
 	return p;
 }
 
+#ifdef TARGET_MEMCPY
+/*
+ * Block moves. A memcpy or memset of a small constant size is turned
+ * into an array STASG so that pass2 can unroll it or use a counted
+ * loop (zzzcode 'I'). The destination is copied to a temp as it is
+ * also the return value. Anything else goes to the library.
+ *
+ * Word moves are only used if both pointers are known to be aligned,
+ * a word access to an odd address silently uses the even one.
+ */
+static int
+wdptr(NODE *p)
+{
+	while (p->n_op == PCONV)
+		p = p->n_left;
+	if (p->n_op == ADDROF)
+		return talign(p->n_left->n_type, p->n_left->n_ap) >= ALINT;
+	if (!ISPTR(p->n_type) || ISFTN(DECREF(p->n_type)))
+		return 0;
+	return talign(DECREF(p->n_type), p->n_ap) >= ALINT;
+}
+
+static NODE *
+blkasg(NODE *d, NODE *s, int n, int wd)
+{
+	union dimfun *df;
+	struct attr *ap;
+	NODE *p, *t;
+	int tn;
+
+	df = tmpalloc(sizeof(union dimfun));
+	df->ddim = n;
+	ap = attr_new(ATTR_ALIGNED, 1);
+	ap->iarg(0) = wd ? ALINT : ALCHAR;
+
+	t = tempnode(0, d->n_type, d->n_df, d->n_ap);
+	tn = regno(t);
+	p = buildtree(ASSIGN, t, d);
+	t = block(UMUL, tempnode(tn, d->n_type, d->n_df, d->n_ap), NIL,
+	    ARY|UCHAR, df, ap);
+	t = block(STASG, t, s, ARY|UCHAR, df, ap);
+	p = block(COMOP, p, t, VOID, 0, 0);	/* no array decay */
+	return buildtree(COMOP, p, tempnode(tn, d->n_type, d->n_df, d->n_ap));
+}
+
+static int
+blkcon(NODE *a)
+{
+	NODE *n = a->n_right;
+
+	if (n->n_op != ICON || n->n_sp != NULL || getlval(n) <= 0 ||
+	    getlval(n) > MEMINLINE)
+		return 0;
+	return (int)getlval(n);
+}
+
+NODE *
+builtin_memcpy(const struct bitable *bt, NODE *a)
+{
+	NODE *d, *s;
+	int n;
+
+	if ((n = blkcon(a)) == 0)
+		return binhelp(a, bt->rt, "memcpy");
+	d = a->n_left->n_left;
+	s = a->n_left->n_right;
+	p1nfree(a->n_right);
+	p1nfree(a->n_left);
+	p1nfree(a);
+	return blkasg(d, s, n, wdptr(d) && wdptr(s));
+}
+
+/*
+ * The fill byte is put in both halves of a word so that pass2 can use
+ * it either for word or byte stores. Only constant fill values.
+ */
+NODE *
+builtin_memset(const struct bitable *bt, NODE *a)
+{
+	NODE *d, *c;
+	int n;
+
+	c = a->n_left->n_right;
+	if ((n = blkcon(a)) == 0 || c->n_op != ICON || c->n_sp != NULL)
+		return binhelp(a, bt->rt, "memset");
+	d = a->n_left->n_left;
+	slval(c, (getlval(c) & 0377) * 0401);
+	c->n_type = UNSIGNED;
+	p1nfree(a->n_right);
+	p1nfree(a->n_left);
+	p1nfree(a);
+	return blkasg(d, c, n, wdptr(d));
+}
+#endif
+
 /* fix up type of field p */
 void
 fldty(struct symtab *p)
@@ -389,12 +495,146 @@ fldty(struct symtab *p)
 }
 
 /*
- * XXX - fix genswitch.
+ * Switch lowering.
+ *
+ * The generic code in cgram.y does a linear chain of compares which
+ * is painfully slow for the big dense switches in interpreters and
+ * protocol decoders. Instead split the (sorted) case list into a
+ * balanced binary search of ci/jgt pairs and, where a run of cases is
+ * dense enough, jump through a table of .word labels with b *Rn.
+ *
+ * While walking down the tree the bounds of the value are known, so
+ * a jump table whose range covers them needs no range check and a
+ * single case that is the only possible value needs no compare.
+ */
+#define	SW_LINEAR	3	/* at most this many cases just compare */
+#define	SW_TABMIN	4	/* at least this many cases for a table */
+#define	SW_TABDENS	3	/* at most 1 in 3 table slots default */
+
+static TWORD swtype;
+static int swnum, swdef;
+
+/* Compare case values in the signedness of the switch */
+static int
+swle(CONSZ a, CONSZ b)
+{
+	if (ISUNSIGNED(swtype))
+		return (U_CONSZ)a <= (U_CONSZ)b;
+	return a <= b;
+}
+
+static P1ND *
+swval(void)
+{
+	return tempnode(swnum, swtype, 0, 0);
+}
+
+#ifndef LANG_CXX
+/*
+ * Jump through a table for cases p[s] to p[e]. The table lives in
+ * the code right behind the indirect branch.
+ */
+static void
+swtable(struct swents **p, int s, int e, int chk)
+{
+	struct symtab *sp;
+	CONSZ lo = p[s]->sval, v;
+	P1ND *q, *r;
+	char buf[32];
+	int i, tv;
+
+	/* idx = val - lo, checked unsigned so it catches both ends */
+	q = tempnode(swnum, UNSIGNED, 0, 0);
+	if (lo)
+		q = buildtree(MINUS, q, bcon((int)lo));
+	r = tempnode(0, UNSIGNED, 0, 0);
+	tv = regno(r);
+	ecomp(buildtree(ASSIGN, r, q));
+	if (chk) {
+		q = tempnode(tv, UNSIGNED, 0, 0);
+		q = buildtree(GT, q, bcon((int)(p[e]->sval - lo)));
+		cbranch(q, bcon(swdef));
+	}
+
+	sp = getsymtab("swtab", SSTMT);
+	sp->stype = UNSIGNED;
+	sp->sclass = STATIC;
+	sp->soffset = getlab();
+	sp->slevel = 1;
+
+	q = buildtree(ADDROF, nametree(sp), NIL);
+	q = buildtree(PLUS, q, tempnode(tv, UNSIGNED, 0, 0));
+	q = buildtree(UMUL, q, NIL);
+	ecomp(block(GOTO, q, NIL, INT, 0, 0));
+
+	snprintf(buf, sizeof(buf), LABFMT ":", sp->soffset);
+	send_passt(IP_ASM, buf);
+	savlab(swdef);
+	for (i = s, v = lo; i <= e; v++) {
+		if (p[i]->sval == v) {
+			snprintf(buf, sizeof(buf), "\t.word\t" LABFMT,
+			    p[i]->slab);
+			savlab(p[i++]->slab);
+		} else
+			snprintf(buf, sizeof(buf), "\t.word\t" LABFMT, swdef);
+		send_passt(IP_ASM, buf);
+	}
+}
+#endif
+
+/*
+ * Generate the search for p[s] to p[e]. If lok/hik are set the value
+ * is known to be at least lo and at most hi.
  */
+static void
+swtree(struct swents **p, int s, int e, CONSZ lo, int lok, CONSZ hi, int hik)
+{
+	P1ND *q;
+	int i, h, lab, full;
+
+#ifndef LANG_CXX
+	if (e - s + 1 >= SW_TABMIN && tsize(swtype, 0, 0) <= SZINT &&
+	    (U_CONSZ)(p[e]->sval - p[s]->sval) < (U_CONSZ)(SW_TABDENS*(e-s+1))) {
+		swtable(p, s, e, !(lok && hik &&
+		    swle(p[s]->sval, lo) && swle(hi, p[e]->sval)));
+		return;
+	}
+#endif
+
+	if (e - s < SW_LINEAR) {
+		/* If the cases are all the value can be skip the last test */
+		full = lok && hik && lo == p[s]->sval && hi == p[e]->sval &&
+		    p[e]->sval - p[s]->sval == e - s;
+		for (i = s; i < e + !full; i++) {
+			q = buildtree(EQ, swval(), xbcon(p[i]->sval, NULL, swtype));
+			cbranch(q, bcon(p[i]->slab));
+		}
+		branch(full ? p[e]->slab : swdef);
+		return;
+	}
+
+	h = s + (e - s) / 2;
+	lab = getlab();
+	q = buildtree(GT, swval(), xbcon(p[h]->sval, NULL, swtype));
+	cbranch(q, bcon(lab));
+	swtree(p, s, h, lo, lok, p[h]->sval, 1);
+	plabel(lab);
+	swtree(p, h+1, e, p[h]->sval + 1, 1, hi, hik);
+}
+
 int
 mygenswitch(int num, TWORD type, struct swents **p, int n)
 {
-	return 0;
+	if (n <= SW_LINEAR)
+		return 0;	/* let the simple code deal with it */
+
+	swnum = num;
+	swtype = type;
+	swdef = p[0]->slab > 0 ? p[0]->slab : getlab();
+	swtree(p, 1, n, 0, ISUNSIGNED(type), 0, 0);
+	if (p[0]->slab <= 0)
+		plabel(swdef);
+	return 1;
 }
 
 /*
@@ -380,18 +380,17 @@ instring(struct symtab *sp)
 	t = BTYPE(sp->stype);
 	s = sp->sname;
 	if (t == UNSIGNED) {
-		printf(".word ");
 		/* convert to UTF-16 */
 		while (*s) {
 			cp2u16(u82cp(&s), sh);
-			if (sh[0]) printf("0x%x\n", sh[0]);
-			if (sh[1]) printf("0x%x\n", sh[1]);
+			if (sh[0]) printf(PRTPREF ".word 0x%x\n", sh[0]);
+			if (sh[1]) printf(PRTPREF ".word 0x%x\n", sh[1]);
 		}
-		printf(".word 0\n");
+		printf(PRTPREF ".word 0\n");
 	} else if (t == CHAR) {
 		for (cnt = 0; *s != 0; ) {
 			if (cnt++ == 0)
-				printf(".byte ");
+				printf(PRTPREF ".byte ");
 			if (*s == '\\')
 				val = esccon(&s);
 			else
@@ -403,7 +402,10 @@ instring(struct symtab *sp)
 			} else
 				printf(",");
 		}
-		printf("%s0\n", cnt ? "" : ".byte ");
+		if (cnt)
+			printf("0\n");
+		else
+			printf(PRTPREF ".byte 0\n");
 	} else
 		cerror("instring");
 }
@@ -478,29 +480,29 @@ ninval(CONSZ off, int fsz, NODE *p)
 		break;
 	case LONG:
 	case ULONG:
-		printf(".word 0x%04x, 0x%04x\n", (int)((glval(p) >> 16) & 0xFFFF),
+		printf(PRTPREF ".word 0x%04x, 0x%04x\n", (int)((glval(p) >> 16) & 0xFFFF),
 		    (int)(glval(p) & 0xFFFF));
 		break;
 #ifndef LANG_CXX
 	/* We need to mangle this into native form */
 	case FLOAT:
 		fn = floatmangle(sfp->fp[0]);
-		printf(".word 0x%04x, 0x%04x\n", (fn >> 16) & 0xFFFF, fn & 0xffff);
+		printf(PRTPREF ".word 0x%04x, 0x%04x\n", (fn >> 16) & 0xFFFF, fn & 0xffff);
 		break;
 	case LDOUBLE:
 	case DOUBLE:
-		printf(".word 0x%04x, 0x%04x, 0x%04x, 0x%04x\n", sfp->fp[1] >> 16,
+		printf(PRTPREF ".word 0x%04x, 0x%04x, 0x%04x, 0x%04x\n", sfp->fp[1] >> 16,
 		    sfp->fp[1] & 0xFFFF, sfp->fp[0] >> 16, sfp->fp[0] & 0xFFFF);
 		break;
 #endif
 	case CHAR:
 	case UCHAR:
-		printf(".byte 0x%02x\n",  (int)(glval(p) & 0xFF));
+		printf(PRTPREF ".byte 0x%02x\n",  (int)(glval(p) & 0xFF));
 		break;
 	case INT:
 	case UNSIGNED:
 	default:
-		printf(".word 0x%x", (int)glval(p));
+		printf(PRTPREF ".word 0x%x", (int)glval(p));
 		if ((q = p->n_sp) != NULL) {
 			if ((q->sclass == STATIC && q->slevel > 0)) {
 				printf("+" LABFMT, q->soffset);
@@ -513,6 +515,42 @@ ninval(CONSZ off, int fsz, NODE *p)
 	return 1;
 }
 
+/*
+ * print out a run of n plain constants of type t, as few lines as possible.
+ */
+void
+inrun(CONSZ off, TWORD t, CONSZ *v, int n)
+{
+	NODE *p;
+	int i;
+
+	switch (t) {
+	case CHAR:
+	case UCHAR:
+		printf(PRTPREF ".byte ");
+		for (i = 0; i < n; i++)
+			printf("0x%02x%s", (int)(v[i] & 0xFF), i < n-1 ? "," : "\n");
+		break;
+	case SHORT:
+	case USHORT:
+	case INT:
+	case UNSIGNED:
+		printf(PRTPREF ".word ");
+		for (i = 0; i < n; i++)
+			printf("0x%x%s", (int)v[i], i < n-1 ? "," : "\n");
+		break;
+	default:
+		p = bcon(0);
+		for (i = 0; i < n; i++, off += sztable[t]) {
+			p->n_type = t;
+			slval(p, v[i]);
+			ninval(off, (int)sztable[t], p);
+		}
+		nfree(p);
+		break;
+	}
+}
+
 /* make a name look like an external name in the local machine */
 char *
 exname(char *p)
@@ -590,32 +628,63 @@ defzero(struct symtab *sp)
 	off = tsize(sp->stype, sp->sdf, sp->sap);
 	off = (off+(SZCHAR-1))/SZCHAR;
 	n = getexname(sp);
-	printf(".bss\n");
+	printf(PRTPREF ".bss\n");
+	defalign(talign(sp->stype, sp->sap));
 	if (sp->sclass == EXTDEF || sp->sclass == EXTERN)
-		printf("	.export %s\n", n);
+		printf(PRTPREF "	.export %s\n", n);
 	if (sp->slevel == 0)
-		printf("%s:", n);
+		printf(PRTPREF "%s:", n);
 	else
-		printf(LABFMT ":", sp->soffset);
+		printf(PRTPREF LABFMT ":", sp->soffset);
 	printf("	.ds %d\n", off);
 	lastloc = -1;
 }
 
+static int gotfast;
+
 /*
  * Give target the opportunity of handling pragmas.
  */
 int
 mypragma(char *str)
 {
+	if (strcmp(str, "fastram") == 0) {
+		gotfast = 1;
+		return 1;
+	}
 	return 0;
 }
 
 /*
  * Called when a identifier has been declared.
+ *
+ * #pragma fastram puts the variables declared in the current statement into
+ * the .fastram segment, which the link places in the on-chip RAM alongside
+ * the workspace. It is the same as __attribute__((section(".fastram"))).
  */
 void
 fixdef(struct symtab *sp)
 {
+#ifdef GCC_COMPAT
+	struct attr *ap;
+
+	if (gotfast && !ISFTN(sp->stype) && (sp->sclass == STATIC ||
+	    sp->sclass == EXTDEF || sp->sclass == EXTERN) &&
+	    attr_find(sp->sap, GCC_ATYP_SECTION) == NULL) {
+		ap = attr_new(GCC_ATYP_SECTION, 1);
+		ap->sarg(0) = ".fastram";
+		sp->sap = attr_add(sp->sap, ap);
+	}
+#endif
+}
+
+/*
+ * End of a declaration statement, or the start of a function body.
+ */
+void
+target_declend(void)
+{
+	gotfast = 0;
 }
 
 unsigned is_va;
@@ -623,6 +692,8 @@ unsigned is_va;
 void
 pass1_lastchance(struct interpass *ip)
 {
+	if (ip->type == IP_PROLOG)
+		((struct interpass_prolog *)ip)->ipp_va = 0;
 	if (ip->type == IP_EPILOG) {
 		struct interpass_prolog *ipp = (struct interpass_prolog *)ip;
 		ipp->ipp_va = is_va;
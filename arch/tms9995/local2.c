@@ -168,17 +168,100 @@ static const char *regname_h(int n)
 	}
 }
 
+/*
+ * Nearly every instruction that writes a result also compares it against
+ * zero. Rules that are known to do so carry RCC bits; remember which
+ * registers the status now reflects so a following test of one of them
+ * can just branch.
+ */
+static int ccregs[2] = { -1, -1 };
+static int ccbyte;	/* status is for the high byte (movb and friends) */
+static int ccmask;
+
+static void
+ccmove(int s, int d, int byte)
+{
+	ccregs[0] = d;
+	ccregs[1] = s;
+	ccbyte = byte;
+	ccmask = RCCZ;
+}
+
+void
+ccset(NODE *p, int cookie, int rw)
+{
+	NODE *l, *r;
+
+	ccregs[0] = ccregs[1] = -1;
+	if (p == NULL || (rw & RCCZ) == 0)
+		return;
+	l = p->n_left;
+	r = p->n_right;
+	if (p->n_op == ASSIGN) {
+		if (l->n_op == REG)
+			ccregs[0] = regno(l);
+		if (r->n_op == REG)
+			ccregs[1] = regno(r);
+	} else if (cookie & INREGS)
+		ccregs[0] = DECRA(p->n_reg, 0);
+	else if ((rw & RLEFT) && l->n_op == REG)
+		ccregs[0] = regno(l);
+	ccbyte = p->n_type == CHAR || p->n_type == UCHAR;
+	ccmask = rw & RCCZ;
+}
+
+/*
+ * Is p, a compare of a register with zero, already in the status?
+ */
+int
+cctest(NODE *p)
+{
+	NODE *l, *r;
+	TWORD t;
+	int need;
+
+	if (p->n_op < EQ || p->n_op > UGT)
+		return 0;
+	l = p->n_left;
+	r = p->n_right;
+	t = l->n_type;
+	if (l->n_op != REG || r->n_op != ICON || getlval(r) != 0 ||
+	    r->n_name[0] != '\0')
+		return 0;
+	if (t != CHAR && t != UCHAR && t != INT && t != UNSIGNED && !ISPTR(t))
+		return 0;
+	if (regno(l) != ccregs[0] && regno(l) != ccregs[1])
+		return 0;
+	if (ccbyte != (t == CHAR || t == UCHAR))
+		return 0;
+	switch (p->n_op) {
+	case EQ:
+	case NE:
+		need = RCCEQ;
+		break;
+	case LE:
+	case LT:
+	case GE:
+	case GT:
+		need = RCCEQ|RCCGT;
+		break;
+	default:
+		need = RCCEQ|RCCHI;
+		break;
+	}
+	return (ccmask & need) == need;
+}
+
 void
 deflab(int label)
 {
 	printf(LABFMT ":\n", label);
+	ccset(NULL, 0, 0);
 }
 
 /* We write the vararg state of the function into the epilogue record. We can't
    write it into the prologue because that happens before we find out. Instead
-   we walk the records to find our end record.
-
-   TODO; We could also check as we walk if we need a frame pointer at all */
+   we walk the records to find our end record. */
 
 static int find_vararg(struct interpass_prolog *ipp)
 {
@@ -193,6 +276,52 @@ static int find_vararg(struct interpass_prolog *ipp)
 	return 0;
 }
 
+/*
+ * Anything that stops us running on the caller's r11 and stack: a call or
+ * a helper (both bl and trash r11), inline asm, or a reference to the frame
+ * pointer (locals, spills, stack arguments) or the stack pointer.
+ */
+static void
+framenode(NODE *p, void *arg)
+{
+	int o = p->n_op;
+
+	if (callop(o) || o == XASM)
+		*(int *)arg = 1;
+	else if ((o == REG || o == OREG) &&
+	    (regno(p) == FPREG || regno(p) == STKREG))
+		*(int *)arg = 1;
+	else if (TBLIDX(p->n_su) &&
+	    strstr(table[TBLIDX(p->n_su)].cstring, "bl\t") != NULL)
+		*(int *)arg = 1;
+}
+
+/*
+ * A leaf function with no locals and no register variables to save has no
+ * use for a frame. Leave the return address in r11 and finish with rt.
+ */
+static int
+needframe(int is_vararg)
+{
+	struct interpass *ip;
+	int i, rv = 0;
+
+	if (is_vararg || kflag || p2maxautooff > AUTOINIT/SZCHAR)
+		return 1;
+	for (i = 6; i < 16; i++)
+		if (TESTBIT(p2env.p_regs, i))
+			return 1;
+	DLIST_FOREACH(ip, &p2env.ipole, qelem) {
+		if (ip->type == IP_ASM)
+			return 1;
+		if (ip->type == IP_NODE)
+			walkf(ip->ip_node, framenode, &rv);
+	}
+	return rv;
+}
+
+static int noframe;
+
 /*
  *	It would be nicer to put the frame pointer at the base of the frame
  *	with all values indexed upwards but that doesn't seem to be handled
@@ -216,6 +345,12 @@ prologue(struct interpass_prolog *ipp)
 		printf(".export	%s\n", ipp->ipp_name);
 	printf("%s:\n", ipp->ipp_name);
 #endif
+	spcoff = 0;
+	ccset(NULL, 0, 0);
+	noframe = needframe(is_vararg) == 0;
+	if (noframe)
+		return;
+
 	/* Because we use a branch and link our stack right now is just the
 	   later arguments. This means we can turn varargs entirely 'normal'
 	   by just pushing these. We already lied slightly to the rest of
@@ -279,25 +414,19 @@ prologue(struct interpass_prolog *ipp)
 	/* Might be better to have an attribute for pic library entry funcs ? */
 	if (kflag)
 		printf("dect	r13\nmov	r15,*r13\n");
-	spcoff = 0;
 }
 
 /* TODO - if we did an alloca() who owned the cleanup ?? */
-void
-eoftn(struct interpass_prolog *ipp)
+/*
+ * Pop the registers saved inline by the prologue. Returns the highest
+ * of r6-r9 saved by the center_r helper, or 5 if none.
+ */
+static int
+popregs(void)
 {
 	int i;
 	int tr;
-	const char *v = "";
 
-	/* Skip the pushed register arguments */
-	if (ipp->ipp_va)
-		v = "v";
-
-	if (spcoff)
-		comperr("spcoff == %d", spcoff);
-	if (ipp->ipp_ip.ip_lbl == 0)
-		return; /* no code needs to be generated */
 	if (kflag)
 		printf("mov	*r13+, r15\n");
 	for (i = 6; i < 10; i++)
@@ -309,6 +438,28 @@ eoftn(struct interpass_prolog *ipp)
 	for (i = 15; i > tr; i--)
 		if (TESTBIT(p2env.p_regs, i))
 			printf("mov	*r13+, %s\n", regname(i));
+	return tr;
+}
+
+void
+eoftn(struct interpass_prolog *ipp)
+{
+	int tr;
+	const char *v = "";
+
+	/* Skip the pushed register arguments */
+	if (ipp->ipp_va)
+		v = "v";
+
+	if (spcoff)
+		comperr("spcoff == %d", spcoff);
+	if (ipp->ipp_ip.ip_lbl == 0)
+		return; /* no code needs to be generated */
+	if (noframe) {
+		printf("rt\n");
+		return;
+	}
+	tr = popregs();
 
 	/* Our helper pushes 6/7 even if only 6 was needed */
 	if (tr == 6)
@@ -327,6 +478,32 @@ eoftn(struct interpass_prolog *ipp)
 	}
 }
 
+/*
+ * Can the frame be torn down inline for a sibling call? We only know the
+ * layout of the plain center frame, the _r and vararg helpers keep their
+ * extra words to themselves.
+ */
+int
+tailcallok(NODE *p)
+{
+	return p2env.epp->ipp_va == 0 && !TESTBIT(p2env.p_regs, 6);
+}
+
+/*
+ * Unwind the frame as cret would, leaving the return address of our
+ * caller in r11, and jump to the function.
+ */
+static void
+tailjump(NODE *p)
+{
+	(void)popregs();
+	printf("mov	r12,r13\n");
+	printf("inct	r13\n");
+	printf("mov	*r13+,r12\n");
+	printf("mov	*r13+,r11\n");
+	expand(p, FOREFF, "b	AL\n");
+}
+
 /*
  * add/sub/...
  *
@@ -469,11 +646,9 @@ twolcomp(NODE *p)
 		expand(p, 0, "c	UL,UR\n");
 	if (cb1) cbgen(cb1, s);
 	if (cb2) cbgen(cb2, e);
-	if (p->n_right->n_op == ICON) {
-		expand(p, 0, "ci	ZL,CR");
-		uconput(stdout, p->n_right);
-		printf("\n");
-	} else
+	if (p->n_right->n_op == ICON)
+		expand(p, 0, "ci	ZL,CR\n");
+	else
 	        expand(p, 0, "c	ZL,ZR\n");
         cbgen(u, e);
         deflab(s);
@@ -559,6 +734,7 @@ static void ofpmove(NODE *p)
 void
 rmove(int s, int d, TWORD t)
 {
+	ccset(NULL, 0, 0);
 	if (t == FLOAT) {
 		fpmove_r(s, d);
 		return;
@@ -567,6 +743,8 @@ rmove(int s, int d, TWORD t)
 	if (t < LONG || t > BTMASK) {
 		printf("mov	%s,%s\n",
 			regname(s), regname(d));
+		ccmove(s, d, 0);
+		return;
 	} else if (t == LONG || t == ULONG || t == FLOAT || t == DOUBLE) {
 		/* avoid trashing double regs */
 		if (d > s)
@@ -692,6 +870,329 @@ static void ori32(NODE *p)
 	}
 }
 
+/* Add a 16bit constant to a register, using the short forms if we can */
+static void addi16(const char *r, unsigned int c)
+{
+	switch(c) {
+	case 1:
+		printf("inc	%s\n", r);
+		break;
+	case 2:
+		printf("inct	%s\n", r);
+		break;
+	case 0xFFFF:
+		printf("dec	%s\n", r);
+		break;
+	case 0xFFFE:
+		printf("dect	%s\n", r);
+		break;
+	default:
+		printf("ai	%s,", r);
+		negcon(stdout, (int)(short)c);
+		printf("\n");
+	}
+}
+
+/* 32bit add or subtract of a constant without the helper call. There
+   is no add with carry so the carry out of the low word is done by hand.
+   A named constant cannot be negated by our toolchain, so subtract it by
+   adding to the complement instead (~(~x + c) == x - c) */
+static void addi32(NODE *p)
+{
+	NODE *r = p->n_right;
+	int l = regno(p->n_left);
+	unsigned int c = getlval(r);
+	unsigned int lo, hi;
+	int named = r->n_name[0] != 0;
+	int lab;
+
+	if (p->n_op == MINUS) {
+		if (named)
+			printf("inv	%s\ninv	%s\n",
+				regname_h(l), regname_l(l));
+		else
+			c = -c;
+	}
+	lo = c & 0xFFFF;
+	hi = (c >> 16) & 0xFFFF;
+	if (named) {
+		expand(p, 0, "ai	ZL,CR\n");
+		lo = 1;
+	} else if (lo)
+		addi16(regname_l(l), lo);
+	if (lo) {
+		lab = getlab2();
+		/* Adding 0xFFFF and the carry leaves the high word alone */
+		if (hi == 0xFFFF) {
+			printf("joc	" LABFMT "\n", lab);
+			printf("dec	%s\n", regname_h(l));
+			hi = 0;
+		} else {
+			printf("jnc	" LABFMT "\n", lab);
+			printf("inc	%s\n", regname_h(l));
+		}
+		deflab(lab);
+	}
+	if (hi)
+		addi16(regname_h(l), hi);
+	if (p->n_op == MINUS && named)
+		printf("inv	%s\ninv	%s\n", regname_h(l), regname_l(l));
+}
+
+/* 32bit shift by a constant without the helper call. The bits that cross
+   between the halves go through the scratch register A1 */
+static void shift32(NODE *p)
+{
+	int l = regno(p->n_left);
+	const char *h = regname_h(l), *lo = regname_l(l), *t;
+	int n = getlval(p->n_right) & 31;
+
+	if (n == 0)
+		return;
+	if (resc[1].n_op == FREE)
+		comperr("shift32: free node");
+	t = regname(regno(&resc[1]));
+
+	if (p->n_op == LS) {
+		if (n >= 16) {
+			printf("mov	%s,%s\nclr	%s\n", lo, h, lo);
+			if (n > 16)
+				printf("sla	%s,%d\n", h, n - 16);
+			return;
+		}
+		printf("mov	%s,%s\nsrl	%s,%d\n", lo, t, t, 16 - n);
+		printf("sla	%s,%d\nsla	%s,%d\n", h, n, lo, n);
+		printf("soc	%s,%s\n", t, h);
+		return;
+	}
+	/* Right shifts, arithmetic for signed */
+	if (n >= 16) {
+		printf("mov	%s,%s\n", h, lo);
+		if (p->n_type == ULONG)
+			printf("clr	%s\n", h);
+		else
+			printf("sra	%s,15\n", h);
+		if (n > 16)
+			printf("%s	%s,%d\n",
+				p->n_type == ULONG ? "srl" : "sra", lo, n - 16);
+		return;
+	}
+	printf("mov	%s,%s\nsla	%s,%d\n", h, t, t, 16 - n);
+	printf("srl	%s,%d\n", lo, n);
+	printf("%s	%s,%d\n", p->n_type == ULONG ? "srl" : "sra", h, n);
+	printf("soc	%s,%s\n", t, lo);
+}
+
+/*
+ * Multiply by a constant with shifts and adds. The multiplier is taken
+ * as signed digits (x * 7 == x * 8 - x) and applied highest first, with
+ * the original value kept in A1. As we work modulo 2^16 a digit for
+ * 2^16 can be dropped, which is how 0xFFFF becomes a negate.
+ *
+ * Fill in the digits and return the cost in cycles, or bytes for
+ * -xspace.
+ */
+static int
+mulchain(unsigned int c, int *d)
+{
+	int i, j, cost, bytes;
+
+	c &= 0xFFFF;
+	for (i = 0; i < 16; i++) {
+		d[i] = 0;
+		if (c & 1) {
+			d[i] = 2 - (c & 3);
+			c -= d[i];
+		}
+		c >>= 1;
+	}
+	/* mov AL,A1 */
+	cost = 3;
+	bytes = 2;
+	for (i = 15; i >= 0 && d[i] == 0; i--)
+		;
+	if (i < 0)
+		return 1000;
+	if (d[i] < 0)
+		cost += 3, bytes += 2;
+	for (j = i--; i >= 0; i--) {
+		if (d[i] == 0)
+			continue;
+		/* sla AL,n then a or s A1,AL */
+		cost += 5 + (j - i) + 4;
+		bytes += 4;
+		j = i;
+	}
+	if (j)
+		cost += 5 + j, bytes += 2;
+	return xspace ? bytes : cost;
+}
+
+static void
+mulcon(NODE *p)
+{
+	const char *l = regname(regno(p->n_left));
+	int d[16];
+	int i, j;
+
+	if (resc[1].n_op == FREE)
+		comperr("mulcon: free node");
+	(void)mulchain(getlval(p->n_right), d);
+	expand(p, 0, "mov	AL,A1\n");
+	for (i = 15; d[i] == 0; i--)
+		;
+	if (d[i] < 0)
+		printf("neg	%s\n", l);
+	for (j = i--; i >= 0; i--) {
+		if (d[i] == 0)
+			continue;
+		printf("sla	%s,%d\n", l, j - i);
+		expand(p, 0, d[i] > 0 ? "a	A1,AL\n" : "s	A1,AL\n");
+		j = i;
+	}
+	if (j)
+		printf("sla	%s,%d\n", l, j);
+}
+
+/*
+ * Find m and s so that x / c == (x * m) >> (16 + s) for all unsigned
+ * 16bit x, with m fitting in a word. Returns the cost in cycles of doing
+ * the divide that way, or -1 if there is no such m.
+ */
+static int
+udivmagic(unsigned int c, unsigned int *mp, int *sp)
+{
+	unsigned long m, t;
+	int s;
+
+	c &= 0xFFFF;
+	if (c < 2 || (c & (c - 1)) == 0)
+		return -1;
+	for (s = 0; s < 16; s++) {
+		t = 1UL << (16 + s);
+		m = (t + c - 1) / c;
+		if (m > 0xFFFF)
+			break;
+		if (m * c - t <= (1UL << s)) {
+			*mp = m;
+			*sp = s;
+			/* li, mpy, srl, mov */
+			return 3 + 23 + (s ? 5 + s : 0) + 3;
+		}
+	}
+	return -1;
+}
+
+/* x / c as a multiply by the reciprocal, the high word is the quotient */
+static void
+udivcon(NODE *p)
+{
+	unsigned int m;
+	int s;
+	const char *h;
+
+	if (resc[1].n_op == FREE)
+		comperr("udivcon: free node");
+	if (udivmagic(getlval(p->n_right), &m, &s) < 0)
+		comperr("udivcon: no magic for %d", (int)getlval(p->n_right));
+	h = regname_h(regno(&resc[1]));
+	printf("li	%s,%u\n", h, m);
+	expand(p, 0, "mpy	AL,");
+	printf("%s\n", h);
+	if (s)
+		printf("srl	%s,%d\n", h, s);
+	expand(p, 0, "mov	");
+	printf("%s,", h);
+	expand(p, 0, "AL\n");
+}
+
+/*
+ * Signed divide and remainder by 2^k. Division has to round towards
+ * zero so negative values are biased by 2^k - 1 first, for the
+ * remainder we subtract the rounded value from the original.
+ */
+static void
+divpow2(NODE *p)
+{
+	int c = getlval(p->n_right);
+	int lab = getlab2();
+	int k;
+	const char *r;
+
+	for (k = 0; (1 << k) != c; k++)
+		;
+	if (p->n_op == DIV) {
+		r = regname(regno(p->n_left));
+		expand(p, 0, "mov	AL,AL\n");
+	} else {
+		if (resc[1].n_op == FREE)
+			comperr("divpow2: free node");
+		r = regname(regno(&resc[1]));
+		expand(p, 0, "mov	AL,A1\n");
+	}
+	printf("jgt	" LABFMT "\njeq	" LABFMT "\n", lab, lab);
+	addi16(r, c - 1);
+	deflab(lab);
+	if (p->n_op == DIV) {
+		printf("sra	%s,%d\n", r, k);
+		return;
+	}
+	printf("andi	%s,%d\n", r, -c);
+	expand(p, 0, "s	A1,AL\n");
+}
+
+/*
+ * Block move of len bytes to *d, either copied from *s or filled with
+ * the word in s (both bytes the same) or zero. Up to BLKUNROLL moves
+ * are unrolled, longer blocks use a counted loop in r0. Word moves
+ * unless either side may be on an odd address.
+ */
+#define	BLKUNROLL	(xspace ? 4 : 8)
+#define	BLKCOPY		0
+#define	BLKFILL		1
+#define	BLKZERO		2
+
+static void
+blkmove(int len, int wd, int how, char *s, char *d)
+{
+	char src[8], *op;
+	int n, lab;
+
+	if (how == BLKZERO && !wd) {
+		printf("clr	%s\n", s);
+		how = BLKFILL;
+	}
+	if (how == BLKCOPY)
+		snprintf(src, sizeof(src), "*%s+", s);
+	else
+		snprintf(src, sizeof(src), "%s", s);
+	n = wd ? len >> 1 : len;
+	op = wd ? "mov" : "movb";
+	if (n <= BLKUNROLL) {
+		while (n-- > 0) {
+			if (how == BLKZERO)
+				printf("clr	*%s+\n", d);
+			else
+				printf("%s	%s,*%s+\n", op, src, d);
+		}
+	} else {
+		lab = getlab2();
+		printf("li	r0,%d\n", n);
+		deflab(lab);
+		if (how == BLKZERO)
+			printf("clr	*%s+\n", d);
+		else
+			printf("%s	%s,*%s+\n", op, src, d);
+		printf("dec	r0\njne	" LABFMT "\n", lab);
+	}
+	if (wd && (len & 1)) {
+		if (how == BLKZERO)
+			printf("sb	*%s,*%s\n", d, d);
+		else
+			printf("movb	%s,*%s\n", src, d);
+	}
+}
+
 static int zzlab;
 
 void zzzcode(NODE *p, int c)
@@ -743,8 +1244,7 @@ void zzzcode(NODE *p, int c)
 		expand(p->n_left->n_left, FOREFF, "inc	AL\n");
 		break;
 #endif
-	/* TODO : unroll for smaller structs */
-	case 'I': /* struct assign. Right in R1, left R2, counter R0. */
+	case 'I': /* struct assign. Right in R2, left to R1, counter R0. */
 		ap = attr_find(p->n_ap, ATTR_P2STRUCT);
 		l = p->n_left;
 		len = ap->iarg(0);
@@ -759,33 +1259,37 @@ void zzzcode(NODE *p, int c)
 				if (r != 1)
 					printf("mov	%s,r1\n", regname(r));
 				if (getlval(l))
-					printf("ai	r1, %d\n", (int)getlval(l));
+					printf("ai	r1,%d\n", (int)getlval(l));
 			}
-		} else
-			printf("li	r1, @%s\n", l->n_name);
-		o = getlab2();
-		printf("li	r0, %d\n", (len + 1) >> 1);
-		deflab(o);
-		printf("mov	*r2+, *r1+\n");
-		printf("dec	r0\njne	" LABFMT "\n", o);
-		break;
-	/* TODO : unroll for smaller structs */
+		} else {
+			printf("li	r1,%s", l->n_name);
+			if (getlval(l))
+				printf("+%d", (int)getlval(l));
+			printf("\n");
+		}
+		l = p->n_right;
+		o = ISPTR(l->n_type) ? BLKCOPY : l->n_op == ICON ? BLKZERO : BLKFILL;
+		blkmove(len, ap->iarg(1) > 1, o, "r2", "r1");
+		break;
 	case 'J': /* struct argument */
 		ap = attr_find(p->n_ap, ATTR_P2STRUCT);
 		o = (ap->iarg(0) + 1) & ~1;
 		if (o == 2)
-			printf("dect	r13");
+			printf("dect	r13\n");
 		else
-			printf("ai	r13, %d", -o);
+			printf("ai	r13,%d\n", -o);
 		printf("mov	r13,r2\n");
-		printf("li	r0, %d\n", o >> 1);
-		deflab(o);
-		printf("mov	*r1+, *r2+\n");
-		printf("dec	r0");
-		printf("jne	" LABFMT "\n", o);
+		blkmove(ap->iarg(1) > 1 ? o : ap->iarg(0), ap->iarg(1) > 1,
+		    BLKCOPY, "r1", "r2");
 		spcoff += argsiz(p);
 		break;
 	/* L see above */
+	case 'K': /* call, or jump for a sibling call */
+		if (attr_find(p->n_ap, ATTR_P2TAILCALL))
+			tailjump(p);
+		else
+			expand(p, FOREFF, "bl	AL\n");
+		break;
 	case 'M': /* Load of an fp reg via OPLTYPE */
 		ofpmove(p);
 		break;
@@ -854,9 +1358,24 @@ void zzzcode(NODE *p, int c)
 	case 'a': /* Optimise and 32bit immediate */
 		andi32(p);
 		break;
+	case 'd': /* Signed divide or remainder by a power of two */
+		divpow2(p);
+		break;
+	case 'm': /* Multiply by a constant with shifts and adds */
+		mulcon(p);
+		break;
 	case 'o': /* Optimise or 32bit immediate */
 		ori32(p);
 		break;
+	case 'p': /* Inline 32bit add/sub immediate */
+		addi32(p);
+		break;
+	case 's': /* Inline 32bit shift by a constant */
+		shift32(p);
+		break;
+	case 'u': /* Unsigned divide by a constant using mpy */
+		udivcon(p);
+		break;
 	default:
 		comperr("zzzcode %c", c);
 	}
@@ -1032,7 +1551,9 @@ adrput(FILE *io, NODE *p)
 				fprintf(io, "*%s", rnames[R2UPK1(r)]);
 		} else
 #endif		
-		if (at)
+		if (AITEST(p->n_rval))
+			fprintf(io, "*%s+", regname(AIUPK(p->n_rval)));
+		else if (at)
 			fprintf(io, "(%s)", regname(p->n_rval));
 		else
 			fprintf(io, "*%s", regname(p->n_rval));
@@ -1296,7 +1817,7 @@ argsiz(NODE *p)
 	if (t == DOUBLE)
 		return 8;
 	if (t == STRTY || t == UNIONTY)
-		return attr_find(p->n_ap, ATTR_P2STRUCT)->iarg(0);
+		return (attr_find(p->n_ap, ATTR_P2STRUCT)->iarg(0) + 1) & ~1;
 	return 2;
 }
 
@@ -1352,7 +1873,10 @@ is1con(NODE *p)
 int
 special(NODE *p, int shape)
 {
+	extern unsigned m_has_divs;
 	int o = p->n_op;
+	unsigned int m;
+	int d[16], s, c;
 
 	switch (shape) {
 	/* Matches for -2 and +2 in some cases.
@@ -1366,6 +1890,26 @@ special(NODE *p, int shape)
 		if (o == ICON && p->n_name[0] == 0 && getlval(p) == -2)
 			return SRDIR;
 		break;
+	/* Beats li and mpy, plus the moves for the r0/r1 pair */
+	case SMULC:
+		if (o == ICON && p->n_name[0] == 0 &&
+		    mulchain(getlval(p), d) < (xspace ? 8 : 30))
+			return SRDIR;
+		break;
+	case SPOW2:
+		if (o == ICON && p->n_name[0] == 0 && getlval(p) > 1 &&
+		    getlval(p) <= 0x4000 && (getlval(p) & (getlval(p) - 1)) == 0)
+			return SRDIR;
+		break;
+	/* Only a few cycles better than clr and div on the 9995, but on
+	   the 9900 div is far slower than mpy */
+	case SUDIVC:
+		if (o != ICON || p->n_name[0] || xspace)
+			break;
+		c = udivmagic(getlval(p), &m, &s);
+		if (c >= 0 && (m_has_divs == 0 || c <= 3 + 28 + 6))
+			return SRDIR;
+		break;
 #if 0
 	case SINCB: /* Check if subject for post-inc */
 		if (p->n_op == ASSIGN && p->n_right->n_op == PLUS &&
@@ -99,7 +99,7 @@ typedef	long long CONSZ;
 typedef	unsigned long long U_CONSZ;
 typedef long long OFFSZ;
 
-#define CONFMT	"%llo"		/* format for printing constants */
+#define CONFMT	"%lld"		/* format for printing constants */
 #define LABFMT	"L%d"		/* format for printing labels */
 #ifdef LANG_F77
 #define BLANKCOMMON "_BLNK_"
@@ -116,6 +116,7 @@ typedef long long OFFSZ;
 #undef	FIELDOPS		/* no bit-field instructions */
 #define TARGET_ENDIAN TARGET_BE /* big endian */
 #define	MYINSTRING
+#define	MYINRUN
 #define	MYALIGN
 
 /* Definitions mostly used in pass2 */
@@ -285,6 +286,31 @@ int COLORMAP(int c, int *r);
 
 //#define R2REGS	1	/* permit double indexing */
 
+/* Post-increment (*Rn+) OREGs, made by the autoinc pass in mip/reader.c */
+#define	AUTOINC
+#define	AIPACK(r)	((r) | 0400)
+#define	AITEST(r)	((r) & 0400)
+#define	AIUPK(r)	((r) & 0377)
+
+/* Sibling calls (-xtailcall), see tailcallok() */
+#define	TAILCALL
+
+/* Remember what the status register holds (RCC* rules), see cctest() */
+#define	CCTRACK
+
+/* Constant sized memcpy/memset become STASG, see code.c */
+#ifndef LANG_CXX
+#define	TARGET_MEMCPY
+#define	TARGET_MEMSET
+#endif
+#define	MEMINLINE	64	/* largest block done inline, in bytes */
+
+/* #pragma fastram lasts to the end of the declaration, see local.c */
+#define	TARGET_DECLEND
+
+/* Auto aggregates may be copied from a template, see init.c blkinit() */
+#define	BLKINIT		20	/* bytes of code for the copy loop */
+
 /* XXX - to die */
 #define FPREG	R12	/* frame pointer */
 #define STKREG	SP	/* stack pointer */
@@ -292,6 +318,12 @@ int COLORMAP(int c, int *r);
 /* A bunch of specials to make life easier for tms9995 */
 #define	STWO		(MAXSPECIAL+1)	/* exactly two */
 #define	SMTWO		(MAXSPECIAL+2)	/* exactly minus two */
+#define	SMULC		(MAXSPECIAL+7)	/* multiplier done with shifts and adds */
+#define	SPOW2		(MAXSPECIAL+8)	/* power of two, 2 to 0x4000 */
+#define	SUDIVC		(MAXSPECIAL+9)	/* unsigned divisor done by reciprocal */
+
+/* Rules that trade size for speed, dropped by acceptable() for -xspace */
+#define	MSPEED		00200
 
 /* Not used yet FIXME: Tidy up */
 #define	SINCB		(MAXSPECIAL+4)	/* post-increment */
@@ -311,4 +343,9 @@ int COLORMAP(int c, int *r);
 #define TARGET_IPP_MEMBERS			\
 	int ipp_va;
 
+#define	target_members_print_prolog(ipp) printf("%d", ipp->ipp_va)
+#define	target_members_print_epilog(ipp) printf("%d", ipp->ipp_va)
+#define	target_members_read_prolog(ipp) ipp->ipp_va = rdint(&p)
+#define	target_members_read_epilog(ipp) ipp->ipp_va = rdint(&p)
+
 extern unsigned int is_va;
@@ -36,6 +36,9 @@
  */
 
 unsigned m_has_divs = 1;		/* TMS9995 has divs, 9900 does not */
+#ifdef PASS2
+unsigned m_discard;	/* set by mflags(), only pass1 (code.c) uses it */
+#endif
 
 /*
  *	Can we addr this ?
@@ -212,8 +215,10 @@ nspecial(struct optab *q)
 		/* FIXME: this is a hack for now. The actual rule is that
 		   reg x mam -> reg;reg+1 */
 		if (q->visit == INAREG) {
+			/* mpy writes r0 and r1 */
 			static struct rspecial s[] = {
-			    { NLEFT, R0 }, { NEVER, R0 },{ NRES, R1 }, { 0 } };
+			    { NLEFT, R0 }, { NEVER, R0 }, { NEVER, R1 },
+			    { NRES, R1 }, { 0 } };
 			return s;
 		} else if (q->visit == INBREG) {
 			if (q->rshape == SCON)
@@ -228,13 +233,13 @@ nspecial(struct optab *q)
 		/* Hack for now */
 		if (q->visit == INAREG) {
 			/* Early machines lack mpys divs so use a helper */
-			if (m_has_divs == 0) {
+			if (m_has_divs == 0 && (q->ltype & TUNSIGNED) == 0) {
 				static struct rspecial s[] = {
-				    { NRIGHT, R2 }, { NLEFT, R1 }, { NEVER, R0 }, { NEVER, R2 }, { NRES, R1 }, { 0 } };
+				    { NRIGHT, R2 }, { NLEFT, R1 }, { NEVER, R0 }, { NEVER, R1 }, { NEVER, R2 }, { NRES, R1 }, { 0 } };
 				return s;
 			} else {
 				static struct rspecial s[] = {
-				    { NORIGHT, R0 }, { NORIGHT, R1 }, { NLEFT, R1 }, { NRES, R0 }, { 0 } };
+				    { NORIGHT, R0 }, { NORIGHT, R1 }, { NLEFT, R1 }, { NEVER, R0 }, { NEVER, R1 }, { NRES, R0 }, { 0 } };
 				    return s;
 			}
 		} else if (q->visit == INBREG) {
@@ -250,13 +255,13 @@ nspecial(struct optab *q)
 		/* Hack for now */
 		if (q->visit == INAREG) {
 			/* Early machines lack mpys divs so use a helper */
-			if (m_has_divs == 0) {
+			if (m_has_divs == 0 && (q->ltype & TUNSIGNED) == 0) {
 				static struct rspecial s[] = {
-				    { NRIGHT, R2 }, { NLEFT, R1 }, { NEVER, R0 }, { NEVER, R2 }, { NRES, R1 }, { 0 } };
+				    { NRIGHT, R2 }, { NLEFT, R1 }, { NEVER, R0 }, { NEVER, R1 }, { NEVER, R2 }, { NRES, R1 }, { 0 } };
 				return s;
 			} else {
 				static struct rspecial s[] = {
-				    { NORIGHT, R0 }, { NORIGHT, R1 }, { NEVER, R0 }, { NLEFT, R1 }, { NRES, R1 }, { 0 } };
+				    { NORIGHT, R0 }, { NORIGHT, R1 }, { NEVER, R0 }, { NEVER, R1 }, { NLEFT, R1 }, { NRES, R1 }, { 0 } };
 				return s;
 			}
 		}
@@ -353,13 +358,19 @@ nspecial(struct optab *q)
 		}
 		break;
 	case STASG: {
-			/* R0 = tmp counter. R1 source, R2 dest */
+			/* R0 = tmp counter. R2 source, R1 dest */
 			static struct rspecial s[] = {
 			    { NEVER, R0 }, { NEVER, R1 }, { NEVER, R2 },
 			    { NRIGHT, R2 }, { NOLEFT, R2 }, { NOLEFT, R0 },
 			    { 0 }
 			};
-			return s;
+			/* clearing, no source */
+			static struct rspecial sz[] = {
+			    { NEVER, R0 }, { NEVER, R1 }, { NEVER, R2 },
+			    { NOLEFT, R2 }, { NOLEFT, R0 },
+			    { 0 }
+			};
+			return q->rshape == SZERO ? sz : s;
 		}
 		break;
 	case STARG: {
@@ -424,8 +435,12 @@ acceptable(struct optab *op)
 	   division 16bit with divs */
 	if (m_has_divs == 0) {
 		if ((op->op == DIV || op->op == MOD) && op->visit == INAREG &&
-			op->rshape == (SAREG|SNAME|SOREG))
+			op->rshape == (SAREG|SNAME|SOREG) &&
+			(op->ltype & TUNSIGNED) == 0)
 			return 0;
 	}
+	/* Inline 32bit arithmetic is bigger than the helper call */
+	if ((op->visit & MSPEED) && xspace)
+		return 0;
 	return 1;
 }
@@ -97,7 +97,7 @@ struct optab table[] = {
 { SCONV,	INAREG,
 	SAREG,	TCHAR,
 	SAREG,	TWORD,
-		0,	RLEFT,
+		0,	RLEFT|RCCZ,
 		"sra	AL,8\n", },
 
 /* FIXME: can we do this one RLEFT in situ ? */
@@ -105,14 +105,14 @@ struct optab table[] = {
 { SCONV,	INAREG,
 	SOREG|SNAME,		TCHAR,
 	SAREG,			TWORD,
-		NAREG|NASL,	RESC1,
+		NAREG|NASL,	RESC1|RCCZ,
 		"movb	AL,A1\nsra	A1,8\n", },
 
 /* Char or unsigned char to int or uint: constant */
 { SCONV,	INAREG,
 	SCON,			TCHAR|TUCHAR,
 	SAREG,			TWORD,
-		NAREG|NASL,	RESC1,
+		NAREG|NASL,	RESC1|RCCZ,
 		"li	A1,CL\n", },
 
 /* FIXME: can we do this one RLEFT in situ ? */
@@ -120,7 +120,7 @@ struct optab table[] = {
 { SCONV,	INAREG,
 	SAREG,	TUCHAR,
 	SAREG,	TWORD,
-		0,	RLEFT,
+		0,	RLEFT|RCCZ,
 		"srl	AL,8\n", },
 
 
@@ -301,13 +301,13 @@ struct optab table[] = {
 	SCON,	TANY,
 	SAREG,	TWORD|TPOINT|TCHAR|TUCHAR,
 		NAREG|NASL,	RESC1,
-		"bl	AL\nZC", },
+		"ZKZC", },
 
 { UCALL,	INAREG,
 	SCON,	TANY,
 	SAREG,	TWORD|TPOINT|TCHAR|TUCHAR,
 		NAREG|NASL,	RESC1,
-		"bl	AL\nZC", },
+		"ZKZC", },
 
 /* Call by pointer of a function returning into an areg */
 
@@ -329,13 +329,13 @@ struct optab table[] = {
 	SCON,	TANY,
 	SBREG|SNAME|SOREG,	TLONG|TULONG,
 		NBREG|NBSL,	RESC1,
-		"bl	AL\nZC", },
+		"ZKZC", },
 
 { UCALL,	INBREG,
 	SCON,	TANY,
 	SBREG,	TLONG|TULONG,
 		NBREG|NBSL,	RESC1,
-		"bl	AL\nZC", },
+		"ZKZC", },
 
 /* Call by pointer of a function returning into a breg (long) */
 
@@ -357,13 +357,13 @@ struct optab table[] = {
 	SCON|SNAME|SOREG,	TANY,
 	SCREG,	TFLOAT,
 		NCREG|NCSL,	RESC1,
-		"bl	AL\nZC", },
+		"ZKZC", },
 
 { UCALL,	INCREG,
 	SCON|SNAME|SOREG,	TANY,
 	SCREG,	TFLOAT,
 		NCREG|NCSL,	RESC1,
-		"bl	AL\nZC", },
+		"ZKZC", },
 
 /* Call by pointer of a function returning into a creg (long) */
 
@@ -384,13 +384,13 @@ struct optab table[] = {
 	SCON,	TANY,
 	SANY,	TANY,
 		0,	0,
-		"bl	AL\nZC", },
+		"ZKZC", },
 
 { UCALL,	FOREFF,
 	SCON,	TANY,
 	SANY,	TANY,
 		0,	0,
-		"bl	AL\nZC", },
+		"ZKZC", },
 
 { CALL,		FOREFF,
 	SAREG|SNAME|SOREG,	TANY,
@@ -449,13 +449,13 @@ struct optab table[] = {
 { PLUS,		FOREFF|INAREG|FORCC,
 	SAREG|SNAME|SOREG,	TWORD|TPOINT,
 	SONE,			TANY,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"inc	AL\n", },
 
 { PLUS,		FOREFF|INAREG|FORCC,
 	SAREG|SNAME|SOREG,	TWORD|TPOINT,
 	STWO,			TANY,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"inct	AL\n", },
 
 /* add one for char to reg, special handling */
@@ -465,6 +465,13 @@ struct optab table[] = {
 		0,	RLEFT|RESCC,
 		"ai	AL, 0x100\n", },
 
+/* No ADC so do the carry by hand. Bigger but faster than the helpers */
+{ PLUS,		INBREG|FOREFF|MSPEED,
+	SBREG,			TLONG|TULONG,
+	SCON,			TLONG|TULONG,
+		0,	RLEFT,
+		"Zp", },
+
 /* No ADC */
 { PLUS,		INBREG|FOREFF,
 	SBREG,			TLONG|TULONG,
@@ -489,34 +496,34 @@ struct optab table[] = {
 { PLUS,		INAREG,
 	SAREG,	TPOINT|TWORD,
 	SAREG,	TINT|TUNSIGNED,
-		0,	RLEFT,
+		0,	RLEFT|RCCZ,
 		"a	AR,AL\n", },
 
 /* Add to reg left and reclaim reg */
 { PLUS,		INAREG|FOREFF|FORCC,
 	SAREG,		TWORD|TPOINT,
 	SCON,			TWORD|TPOINT,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"ai	AL,CR\n", },
 
 /* Add to reg left and reclaim reg */
 { PLUS,		INAREG|FOREFF|FORCC,
 	SAREG|SNAME|SOREG,	TWORD|TPOINT,
 	SAREG|SNAME|SOREG,	TWORD|TPOINT,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"a	AR,AL\n", },
 
 /* Add to anything left but use only for side effects */
 { PLUS,		FOREFF|FORCC,
 	SNAME|SOREG,	TWORD|TPOINT,
 	SAREG|SNAME|SOREG,	TWORD|TPOINT,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"a	AR,AL\n", },
 
 { PLUS,		INAREG|FOREFF|FORCC,
 	SAREG,			TCHAR|TUCHAR,
 	SAREG|SNAME|SOREG,	TCHAR|TUCHAR,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"ab	AR,AL\n", },
 
 /* No aib so use a literal */
@@ -534,6 +541,20 @@ struct optab table[] = {
 		NSPECIAL,	RDEST,
 		"ar	AR ; plus into AL\n", },
 
+/* Inline versions first, the helpers are used for -xspace */
+{ MINUS,		INBREG|FOREFF|MSPEED,
+	SBREG,		TLONG|TULONG,
+	SCON,		TLONG|TULONG,
+		0,	RLEFT,
+		"Zp", },
+
+/* S sets carry when there is no borrow */
+{ MINUS,		INBREG|FOREFF|MSPEED,
+	SBREG,		TLONG|TULONG,
+	SBREG,		TLONG|TULONG,
+		0,	RLEFT,
+		"ZBs	UR,UL\ns	ZR,ZL\njoc	ZE\ndec	UL\nZD", },
+
 { MINUS,		INBREG|FOREFF,
 	SBREG,		TLONG|TULONG,
 	SONE,		TLONG|TULONG,
@@ -543,33 +564,33 @@ struct optab table[] = {
 { MINUS,		INBREG|FOREFF,
 	SBREG,		TLONG|TULONG,
 	SCON,		TLONG|TULONG,
-		NSPECIAL,	RDEST,
+		NSPECIAL,	RLEFT,
 		/* Words reversed for speed */
 		"bl	@sub32i\n.word	CR\n.word	ZQ\n", },
 
 { MINUS,		INBREG|FOREFF,
 	SBREG,		TLONG|TULONG,
 	SBREG,		TLONG|TULONG,
-		NSPECIAL,	RDEST,
+		NSPECIAL,	RLEFT,
 		"bl	@sub32\n", },
 
 /* Sub one from anything left */
 { MINUS,	FOREFF|INAREG|FORCC,
 	SAREG|SNAME|SOREG,	TWORD|TPOINT,
 	SONE,			TANY,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"dec	AL\n", },
 
 { MINUS,	FOREFF|INAREG|FORCC,
 	SAREG|SNAME|SOREG,	TWORD|TPOINT,
 	STWO,			TANY,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"dect	AL\n", },
 
 { MINUS,		INAREG|FOREFF,
 	SAREG,			TWORD|TPOINT,
 	SNAME|SOREG|SAREG,	TWORD|TPOINT,
-		0,	RLEFT,
+		0,	RLEFT|RCCZ,
 		"s	AR,AL\n", },
 
 /* We'd like to do this but our toolchain can't resolve things like
@@ -578,7 +599,7 @@ struct optab table[] = {
 { MINUS,		INAREG|FOREFF,
 	SAREG,			TWORD|TPOINT,
 	SCON,			TWORD|TPOINT,
-		0,	RLEFT,
+		0,	RLEFT|RCCZ,
 		"ai	AL,-CR\n", },
 #endif
 
@@ -594,7 +615,7 @@ struct optab table[] = {
 { MINUS,		FOREFF,
 	SAREG|SNAME|SOREG,	TCHAR|TUCHAR,
 	SAREG|SNAME|SOREG,	TCHAR|TUCHAR,
-		0,	RLEFT,
+		0,	RLEFT|RCCZ,
 		"sb	AR,AL\n", },
 
 { MINUS,		FOREFF,
@@ -617,6 +638,13 @@ struct optab table[] = {
  * must be 1-15. Need to check compiler never tries to output silly values
  */
  
+/* Constant 32bit shifts inline, A1 carries the bits between the halves */
+{ LS,	INBREG|FOREFF|MSPEED,
+	SBREG,	TLONG|TULONG,
+	SCON,	TINT|TUNSIGNED,
+		NAREG,	RLEFT,
+		"Zs", },
+
 { LS,	INBREG|FOREFF,
 	SBREG,	TLONG|TULONG,
 	SCON,	TINT|TUNSIGNED,
@@ -698,6 +726,12 @@ struct optab table[] = {
 
 /* And 32bit */
 
+{ RS,	INBREG|FOREFF|MSPEED,
+	SBREG,	TLONG|TULONG,
+	SCON,	TWORD,
+		NAREG,	RLEFT,
+		"Zs", },
+
 { RS,	INBREG|FOREFF,
 	SBREG,	TLONG,
 	SCON,	TWORD,
@@ -800,19 +834,19 @@ struct optab table[] = {
 { ASSIGN,	FOREFF|INAREG|FORCC,
 	SAREG,			TWORD|TPOINT,
 	SCON,			TWORD|TPOINT,
-		0,	RDEST|RESCC,
+		0,	RDEST|RESCC|RCCZ,
 		"li	AL,CR\n", },
 
 { ASSIGN,	FOREFF|INAREG|FORCC,
 	SAREG,			TWORD|TPOINT,
 	SAREG|SNAME|SOREG,	TWORD|TPOINT,
-		0,	RDEST|RESCC,
+		0,	RDEST|RESCC|RCCZ,
 		"mov	AR,AL; 1 AL AR\n", },
 
 { ASSIGN,	FOREFF|INAREG|FORCC,
 	ARONS,	TWORD|TPOINT,
 	SAREG,	TWORD|TPOINT,
-		0,	RDEST|RESCC,
+		0,	RDEST|RESCC|RCCZ,
 		"mov	AR,AL; 2\n", },
 
 #if 0
@@ -832,19 +866,19 @@ struct optab table[] = {
 { ASSIGN,	FOREFF|INAREG|FORCC,
 	SAREG,		TCHAR|TUCHAR,
 	ARONS	,	TCHAR|TUCHAR,
-		0,	RDEST|RESCC,
+		0,	RDEST|RESCC|RCCZ,
 		"movb	AR,AL\n", },
 
 { ASSIGN,	FOREFF|INAREG|FORCC,
 	SAREG,		TCHAR|TUCHAR,
 	SCON,		TCHAR|TUCHAR,
-		0,	RDEST|RESCC,
+		0,	RDEST|RESCC|RCCZ,
 		"li	AL, CR*256\n", },
 
 { ASSIGN,	FOREFF|INAREG|FORCC,
 	ARONS,	TCHAR|TUCHAR,
 	SAREG,	TCHAR|TUCHAR,
-		0,	RDEST|RESCC,
+		0,	RDEST|RESCC|RCCZ,
 		"movb	AR,AL\n", },
 
 { ASSIGN,	FOREFF|FORCC,
@@ -875,6 +909,19 @@ struct optab table[] = {
 	SAREG,		TPTRTO|TANY,
 		NSPECIAL,	RDEST,
 		"ZI", },
+
+/* Block fills from memset, see builtin_memset() */
+{ STASG,	FOREFF|INAREG,
+	SOREG|SNAME,	TANY,
+	SZERO,		TANY,
+		NSPECIAL,	RDEST,
+		"ZI", },
+
+{ STASG,	FOREFF|INAREG,
+	SOREG|SNAME,	TANY,
+	SAREG,		TWORD,
+		NSPECIAL,	RDEST,
+		"ZI", },
 /*
  * DIV/MOD/MUL 
  *
@@ -886,17 +933,25 @@ struct optab table[] = {
  *
  *	This is a fudge to get us working
  */
+/* Constants first, these avoid the fixed registers of mpy and div */
+{ MUL,	INAREG,
+	SAREG,			TWORD,
+	SMULC,			TWORD,
+		NAREG,	RLEFT,
+		"Zm", },
+
+/* mpy leaves the product in r0/r1, the low word is our result */
 { MUL,	INAREG,
 	SAREG,			TWORD|TPOINT,
 	SAREG|SOREG|SNAME,	TWORD|TPOINT,
-		NSPECIAL,	RLEFT,
+		NSPECIAL,	RDEST,
 		"mpy	AR,AL\n", },
 
 { MUL,	INBREG,
 	SBREG,			TLONG|TULONG,
 	SCON,			TLONG|TULONG,
 		NSPECIAL,		RLEFT,
-		"bl	@mul32i\n.word	UR\n.word	ZQ\n", },
+		"bl	@mul32i\n.word	ZQ\n.word	CR\n", },
 
 { MUL,	INBREG,
 	SBREG,			TLONG|TULONG,
@@ -910,6 +965,18 @@ struct optab table[] = {
 		NSPECIAL,	RDEST,
 		"mr	AR; AL *= AR\n", },
 
+{ DIV,	INAREG,
+	SAREG,			TINT,
+	SPOW2,			TINT,
+		0,	RLEFT,
+		"Zd", },
+
+{ DIV,	INAREG,
+	SAREG,			TUNSIGNED,
+	SUDIVC,			TUNSIGNED,
+		NBREG,	RLEFT,
+		"Zu", },
+
 /* signed divide r0/r1 by operand into r0/r1 (r1 = remainder) */
 /* We only have a 32 by 16 divide so sign extend first */
 { DIV,	INAREG,
@@ -962,16 +1029,22 @@ struct optab table[] = {
 		NSPECIAL,	RDEST,
 		"dr	AR; AL /= AR\n", },
 
+{ MOD,	INAREG,
+	SAREG,			TINT,
+	SPOW2,			TINT,
+		NAREG,	RLEFT,
+		"Zd", },
+
 /* signed divide r0/r1 by operand into r0/r1 (r1 = remainder) */
 
 { MOD,	INAREG,
 	SAREG,			TINT|TPOINT,
 	SAREG|SNAME|SOREG,	TINT|TPOINT,
 		NSPECIAL,	RDEST,
-		"clr	r0\ndivs	AR\n", },
+		"clr	r0\nci	r1,0x8000\nZBjl	ZE\ndec	r0\nZD\ndivs	AR\n", },
 
 /* Older processors don't have divs */
-{ DIV,	INAREG,
+{ MOD,	INAREG,
 	SAREG,			TINT|TPOINT,
 	SAREG,			TINT|TPOINT,
 		NSPECIAL,	RDEST,
@@ -1021,13 +1094,13 @@ struct optab table[] = {
 { UMUL,	INAREG,
 	SANY,	TPOINT|TWORD,
 	SOREG|SNAME,	TPOINT|TWORD,
-		NAREG|NASL,	RESC1,
+		NAREG|NASL,	RESC1|RCCZ,
 		"mov	AL,A1\n", },
 
 { UMUL,	INAREG,
 	SANY,	TPOINT | TWORD,
 	SOREG|SNAME,	TCHAR|TUCHAR,
-		NAREG|NASL,	RESC1,
+		NAREG|NASL,	RESC1|RCCZ,
 		"movb	AL,A1\n", },
 
 /* Use a pair of moves. For FR0 we could use LR but it's likely to be
@@ -1129,13 +1202,13 @@ struct optab table[] = {
 { AND,	INAREG|FORCC|FOREFF,
 	SAREG|SNAME|SOREG,	TWORD,
 	SAREG|SOREG|SNAME,	TWORD,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"szc	AR,AL\n", },
 
 { AND,	INAREG|FORCC|FOREFF,
 	SAREG,		TWORD,
 	SCON,		TWORD,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"andi	AL,CR\n", },
 
 /* AND with char */
@@ -1163,26 +1236,26 @@ struct optab table[] = {
 { OR,	FOREFF|INAREG|FORCC,
 	ARONS,		TWORD,
 	ARONS,		TWORD,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"soc	AR,AL\n", },
 
 { OR,	FOREFF|INAREG|FORCC,
 	SAREG,		TWORD,
 	SCON,		TWORD,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"ori	AL,CR\n", },
 
 /* OR with char */
 { OR,	INAREG|FORCC,
 	SAREG|SOREG|SNAME,	TCHAR|TUCHAR,
 	ARONS,			TCHAR|TUCHAR,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"socb	AR,AL\n", },
 
 { OR,	INAREG|FORCC,
 	SAREG|SOREG|SNAME,	TCHAR|TUCHAR,
 	SCON,			TCHAR|TUCHAR,
-		0,	RLEFT|RESCC,
+		0,	RLEFT|RESCC|RCCZ,
 		"socb	@_litb_ZT,AL\n", },
 
 /* No XORI */
@@ -1205,11 +1278,13 @@ struct optab table[] = {
  * Jumps.
  */
 { GOTO, 	FOREFF,
-	SCON|SNAME|SOREG,	TANY,
+	SCON,	TANY,
 	SANY,	TANY,
 		0,	RNOP,
 		"b	@LL\n", },
 
+/* There is no memory indirect branch so computed gotos go via a reg */
+
 { GOTO, 	FOREFF,
 	SAREG,	TANY,
 	SANY,	TANY,
@@ -1244,25 +1319,25 @@ struct optab table[] = {
 { OPLTYPE,	INAREG,
 	SANY,	TANY,
 	SCON,		TWORD|TPOINT,
-		NAREG,	RESC1,
+		NAREG,	RESC1|RCCZ,
 		"li	A1,CL\n", },
 
 { OPLTYPE,	INAREG,
 	SANY,	TANY,
 	SCON,		TCHAR|TUCHAR,
-		NAREG,	RESC1,
+		NAREG,	RESC1|RCCZ,
 		"li	A1, CL*256\n", },
 
 { OPLTYPE,	INAREG,
 	SANY,	TANY,
 	SAREG|SOREG|SNAME,	TWORD|TPOINT,
-		NAREG|NASR,	RESC1,
+		NAREG|NASR,	RESC1|RCCZ,
 		"mov	AL,A1\n", },
 
 { OPLTYPE,	INAREG,
 	SANY,	TANY,
 	SAREG|SOREG|SNAME,	TCHAR|TUCHAR,
-		NAREG,		RESC1,
+		NAREG,		RESC1|RCCZ,
 		"movb	AL,A1\n", },
 
 { OPLTYPE,	INCREG,
@@ -1302,7 +1377,7 @@ struct optab table[] = {
 { COMPL,	INAREG,
 	SAREG,	TWORD,
 	SANY,	TANY,
-		0,	RLEFT,
+		0,	RLEFT|RCCZ,
 		"inv	AL\n", },
 
 /*
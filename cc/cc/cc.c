@@ -270,6 +270,7 @@ static int compile_input(char *input, char *output);
 static int assemble_input(char *input, char *output);
 static int run_linker(void);
 static int strlist_exec(struct strlist *l);
+static void pipe_wait(char *);
 static char *select_linker(char *);
 
 char *cat(const char *, const char *);
@@ -298,6 +299,7 @@ char *win32commandline(struct strlist *l);
 #endif
 int	sspflag;
 int	freestanding;
+int	nobuiltin;
 int	Sflag;
 int	cflag;
 int	gflag;
@@ -307,6 +309,8 @@ int	noexec;	/* -### */
 int	tflag;
 int	Eflag;
 int	Oflag;
+int	Osflag;
+int	O2flag;
 int	kflag;	/* generate PIC/pic code */
 #define F_PIC	1
 #define F_pic	2
@@ -317,6 +321,9 @@ int	Xflag;
 int	nostartfiles, Bstatic, shared;
 int	nostdinc, nostdlib;
 int	pthreads;
+int	pipeflag;
+static int pipe_in = -1;	/* -pipe: read end for the next stage */
+static int pipe_next;		/* -pipe: next stage writes into a pipe */
 int	xgnu89, xgnu99, c89defs, c99defs, c11defs;
 int 	ascpp;
 #ifdef CHAR_UNSIGNED
@@ -633,6 +640,8 @@ main(int argc, char *argv[])
 				kflag = j ? 0 : *u == 'P' ? F_PIC : F_pic;
 			} else if (match(u, "freestanding")) {
 				freestanding = j ? 0 : 1;
+			} else if (match(u, "builtin")) {
+				nobuiltin = j;
 			} else if (match(u, "signed-char")) {
 				xuchar = j ? 1 : 0;
 			} else if (match(u, "unsigned-char")) {
@@ -769,9 +778,11 @@ main(int argc, char *argv[])
 				pgflag++;
 			else if (strcmp(argp, "-pthread") == 0)
 				pthreads++;
-			else if (strcmp(argp, "-pipe") == 0)
-				/* NOTHING YET */;
-			else if (strcmp(argp, "-pedantic") == 0)
+			else if (strcmp(argp, "-pipe") == 0) {
+#ifndef _WIN32	/* strlist_exec() has no pipes on win32 */
+				pipeflag = 1;
+#endif
+			} else if (strcmp(argp, "-pedantic") == 0)
 				/* NOTHING YET */;
 			else if ((t = argnxt(argp, "-print-prog-name="))) {
 				fname = t;
@@ -861,6 +872,7 @@ main(int argc, char *argv[])
 			break;
 
 		case 'O':
+			Osflag = 0;
 			if (argp[2] == '\0')
 				/* gcc does -O1, clang does -O2 */
 				Oflag = 1;	/* do what gcc does */
@@ -868,9 +880,10 @@ main(int argc, char *argv[])
 			    isdigit((unsigned char)argp[2]))
 				Oflag = argp[2] - '0';
 			else if (argp[3] == '\0' && argp[2] == 's')
-				Oflag = 1;	/* optimize for space only */
+				Oflag = Osflag = 1;	/* optimize for space */
 			else
 				oerror(argp);
+			O2flag = Oflag > 1;
 			break;
 
 		case 'P':
@@ -1114,6 +1127,10 @@ main(int argc, char *argv[])
 			if (Eflag) {
 				/* last pass */
 				ofile = outfile;
+			} else if (pipeflag && !ascpp) {
+				/* to the compiler on stdin */
+				ofile = NULL;
+				pipe_next = 1;
 			} else {
 				/* to temp file */
 				strlist_append(&temp_outputs, ofile = gettmp());
@@ -1122,7 +1139,7 @@ main(int argc, char *argv[])
 				exandrm(ofile);
 			if (Eflag)
 				continue;
-			ifile = ofile;
+			ifile = ofile ? ofile : "-";
 			suffix = match(suffix, "S") ? "s" : "i";
 		}
 
@@ -1139,6 +1156,7 @@ main(int argc, char *argv[])
 				strlist_append(&temp_outputs, ofile = gettmp());
 			if (compile_input(ifile, ofile))
 				exandrm(ofile);
+			pipe_wait(ofile);
 			if (Sflag)
 				continue;
 			ifile = ofile;
@@ -1291,7 +1309,11 @@ compile_input(char *input, char *output)
 	char *tfile;
 	int retval;
 
-	strlist_append(&temp_outputs, tfile = gettmp());
+	if (pipeflag) {
+		tfile = "-";
+		pipe_next = 1;
+	} else
+		strlist_append(&temp_outputs, tfile = gettmp());
 
 	strlist_init(&args);
 	strlist_append_list(&args, &compiler_flags);
@@ -1323,7 +1345,10 @@ compile_input(char *input, char *output)
 	int retval;
 
 	tfile = output;
-	if (C2check)
+	if (C2check && pipeflag) {
+		tfile = "-";
+		pipe_next = 1;
+	} else if (C2check)
 		strlist_append(&temp_outputs, tfile = gettmp());
 
 	strlist_init(&args);
@@ -1565,8 +1590,69 @@ strlist_exec(struct strlist *l)
 	return (exitCode != 0);
 }
 
+static void
+pipe_wait(char *ofile)
+{
+}
+
 #else
 
+/*
+ * With -pipe the stages for one file run at the same time.  A stage
+ * reads the pipe in pipe_in if set, and writes into a new pipe if
+ * pipe_next is set.  Such stages are only started by strlist_exec(),
+ * pipe_wait() collects them when the last one is started.
+ */
+#define	MAXPIPE	8
+static pid_t pipe_pids[MAXPIPE];
+static char *pipe_names[MAXPIPE];
+static int npipe;
+
+/*
+ * Complain about a stage that did not exit with status 0.
+ */
+static void
+stagefail(char *name, int st)
+{
+	if (WIFSIGNALED(st))
+		errorx(1, "%s terminated by signal %d", name, WTERMSIG(st));
+	errorx(1, "%s terminated with status %d", name, WEXITSTATUS(st));
+}
+
+/*
+ * Wait for all stages in the pipeline.  A stage killed by SIGPIPE has
+ * only lost its reader, so rather blame the one that failed first.
+ * If any stage failed the output in ofile is incomplete and removed.
+ */
+static void
+pipe_wait(char *ofile)
+{
+	int i, st, bad, badst;
+
+	bad = -1;
+	badst = 0;
+	for (i = 0; i < npipe; i++) {
+		while (waitpid(pipe_pids[i], &st, 0) == -1 && errno == EINTR)
+			/* nothing */(void)0;
+		if (st == 0)
+			continue;
+		if (bad < 0 || (WIFSIGNALED(badst) &&
+		    WTERMSIG(badst) == SIGPIPE && !(WIFSIGNALED(st) &&
+		    WTERMSIG(st) == SIGPIPE))) {
+			bad = i;
+			badst = st;
+		}
+	}
+	if (bad >= 0) {
+		if (ofile && *ofile)
+			strlist_append(&temp_outputs, ofile);
+		stagefail(pipe_names[bad], badst);
+	}
+	for (i = 0; i < npipe; i++)
+		free(pipe_names[i]);
+	npipe = 0;
+}
+
 static int
 strlist_exec(struct strlist *l)
 {
@@ -1575,19 +1661,32 @@ strlist_exec(struct strlist *l)
 	char **argv;
 	size_t argc;
 	ssize_t result;
-	int rv;
+	int rv, pfd[2];
 
 	strlist_make_array(l, &argv, &argc);
 	if (vflag) {
 		printf("Calling ");
 		strlist_print(l, stdout, noexec, " ");
-		printf("\n");
+		printf("%s\n", pipe_next ? " |" : "");
 	}
-	if (noexec)
+	if (noexec) {
+		pipe_next = 0;
 		return 0;
+	}
 
+	if (pipe_next && pipe(pfd) == -1)
+		errorx(1, "pipe failed: %s", strerror(errno));
 	switch ((child = fork())) {
 	case 0:
+		if (pipe_in >= 0) {
+			dup2(pipe_in, STDIN_FILENO);
+			close(pipe_in);
+		}
+		if (pipe_next) {
+			dup2(pfd[1], STDOUT_FILENO);
+			close(pfd[0]);
+			close(pfd[1]);
+		}
 		execvp(argv[0], argv);
 		result = write(STDERR_FILENO, "Exec of ", 8);
 		result = write(STDERR_FILENO, argv[0], strlen(argv[0]));
@@ -1597,11 +1696,25 @@ strlist_exec(struct strlist *l)
 	case -1:
 		errorx(1, "fork failed");
 	default:
-		while (waitpid(child, &rv, 0) == -1 && errno == EINTR)
-			/* nothing */(void)0;
-		rv = WEXITSTATUS(rv);
-		if (rv)
-			errorx(1, "%s terminated with status %d", argv[0], rv);
+		if (pipe_in >= 0 || pipe_next) {
+			if (npipe == MAXPIPE)
+				errorx(1, "too many pipeline stages");
+			pipe_pids[npipe] = child;
+			pipe_names[npipe++] = xstrdup(argv[0]);
+			if (pipe_in >= 0)
+				close(pipe_in);
+			pipe_in = -1;
+			if (pipe_next) {
+				close(pfd[1]);
+				pipe_in = pfd[0];
+				pipe_next = 0;
+			}
+		} else {
+			while (waitpid(child, &rv, 0) == -1 && errno == EINTR)
+				/* nothing */(void)0;
+			if (rv)
+				stagefail(argv[0], rv);
+		}
 		while (argc-- > 0)
 			free(argv[argc]);
 		free(argv);
@@ -1961,7 +2074,11 @@ struct flgcheck ccomflgcheck[] = {
 	{ &Oflag, 1, "-xinline" },
 	{ &Oflag, 1, "-xdce" },
 	{ &Oflag, 1, "-xssa" },
+	{ &O2flag, 1, "-xcse" },
+	{ &O2flag, 1, "-xloop" },
+	{ &Osflag, 1, "-xspace" },
 	{ &freestanding, 1, "-ffreestanding" },
+	{ &nobuiltin, 1, "-fno-builtin" },
 	{ &pgflag, 1, "-p" },
 	{ &gflag, 1, "-g" },
 	{ &xgnu89, 1, "-xgnu89" },
@@ -521,7 +521,7 @@ builtin_va_copy(const struct bitable *bt, P1ND *a)
  * For unimplemented "builtin" functions, try to invoke the
  * non-builtin name
  */
-static P1ND *
+P1ND *
 binhelp(P1ND *a, TWORD rt, char *n)
 {
 	P1ND *f = block(NAME, NULL, NULL, INT, 0, 0);
@@ -1049,6 +1049,42 @@ builtin_check(struct symtab *sp, P1ND *a)
 	return (*bt->fun)(bt, a);
 }
 
+/*
+ * A call of memcpy or memset is expanded like the __builtin_ form if
+ * the target can, but only if it is declared as in <string.h>.  Any
+ * other declaration is the user's own function.  Returns the symbol
+ * to call.
+ */
+struct symtab *
+builtin_lib(struct symtab *sp)
+{
+	union arglist *al;
+	TWORD *tp = NULL;
+	char *n = NULL;
+	int i;
+
+	if (freestanding || nobuiltin)
+		return sp;
+#ifdef TARGET_MEMCPY
+	if (strcmp(sp->sname, "memcpy") == 0)
+		n = "__builtin_memcpy", tp = memcpyt;
+#endif
+#ifdef TARGET_MEMSET
+	if (strcmp(sp->sname, "memset") == 0)
+		n = "__builtin_memset", tp = memsett;
+#endif
+	if (n == NULL || sp->stype != INCREF(VOID|PTR) + (FTN-PTR))
+		return sp;
+	if ((al = sp->sdf->dfun) != NULL) {
+		for (i = 0; i < 3; i++)
+			if (al[i].type != tp[i])
+				return sp;
+		if (al[3].type != TNULL)
+			return sp;
+	}
+	return lookup(addname(n), 0);
+}
+
 /*
  * Put all builtin functions into the global symbol table.
  */
@@ -212,7 +212,6 @@ static P1ND *dogen(struct genlist *g, P1ND *e);
 static struct genlist *newgen(P1ND *p, P1ND *q);
 static struct genlist *addgen(struct genlist *g, struct genlist *h);
 
-static void savlab(int);
 static void xcbranch(P1ND *, int);
 extern int *mkclabs(void);
 
@@ -586,10 +585,19 @@ block_item:	   declaration
 /*
  * Variables are declared in init_declarator.
  */
-declaration:	   declaration_specifiers ';' { p1tfree($1); fun_inline = 0; }
+declaration:	   declaration_specifiers ';' {
+			p1tfree($1);
+			fun_inline = 0;
+#ifdef TARGET_DECLEND
+			target_declend();
+#endif
+		}
 		|  declaration_specifiers init_declarator_list ';' {
 			p1tfree($1);
 			fun_inline = 0;
+#ifdef TARGET_DECLEND
+			target_declend();
+#endif
 		}
 		|  C_STATICASSERT '(' e ',' string ')' ';' {
 			int r = con_e($3);
@@ -1863,6 +1871,9 @@ fundef(P1ND *tp, P1ND *p)
 
 	cftnsp = s;
 	defid(p, class);
+#ifdef TARGET_DECLEND
+	target_declend();
+#endif
 	if (s->sdf->dfun == 0 && !issyshdr)
 		warner(Wstrict_prototypes);
 #ifdef GCC_COMPAT
@@ -2261,6 +2272,8 @@ eve(P1ND *p)
 		if (p1->n_op == NAME) {
 			sp = lookup((char *)p1->n_sp, 0);
 #ifndef NO_C_BUILTINS
+			if ((sp->sflags & SBUILTIN) == 0)
+				sp = builtin_lib(sp);
 			if (sp->sflags & SBUILTIN) {
 				p1nfree(p1);
 				r = builtin_check(sp, p2);
@@ -2521,7 +2534,10 @@ struct labs {
 	int lab;
 } *labp;
 
-static void
+/*
+ * Remember a label that may be reached through a computed goto.
+ */
+void
 savlab(int lab)
 {
 	struct labs *l = tmpalloc(sizeof(struct labs)); /* uncommon */
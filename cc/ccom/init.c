@@ -81,6 +81,9 @@
  *			- prints an integer constant which may have
  *			  a label associated with it, located at off and
  *			  size fsz.
+ * inrun(CONSZ off, TWORD t, CONSZ *v, int n)
+ *			- prints n plain integer constants of type t
+ *			  starting at off (if MYINRUN).
  *
  * Initialization may be of different kind:
  * - Initialization at compile-time, all values are constants and laid
@@ -135,6 +138,7 @@ static struct symtab *csym;
 
 #ifdef PCC_DEBUG
 static void prtstk(struct instk *in);
+static void prtinit(void);
 #define	ID(x) if (idebug) printf x
 #else
 #define ID(x)
@@ -142,20 +146,25 @@ static void prtstk(struct instk *in);
 
 /*
  * Linked lists for initializations.
+ * Plain integer constants to static variables are packed into the ilist
+ * entry itself (n == NULL) so that the node can be freed at once.
  */
 struct ilist {
 	struct ilist *next;
 	CONSZ off;	/* bit offset of this entry */
 	int fsz;	/* bit size of this entry */
 	NODE *n;	/* node containing this data info */
+	TWORD t;	/* type of packed value */
+	CONSZ val;	/* packed value */
 };
 
 struct llist {
-	SLIST_ENTRY(llist) next;
 	CONSZ begsz;	/* bit offset of this entry */
 	struct ilist *il;
+	struct ilist *last;	/* last entry in il, for fast append */
 };
-static SLIST_HEAD(llh, llist) lpole;
+static struct llist **llarr;	/* base elements, indexed by off/basesz */
+static int llasz;	/* # of slots in llarr */
 static CONSZ basesz;
 static int numents; /* # of array entries allocated */
 
@@ -163,11 +172,42 @@ static struct initctx {
 	struct initctx *prev;
 	struct instk *pstk;
 	struct symtab *psym;
-	struct llh lpole;
+	struct llist **llarr;
+	int llasz;
 	CONSZ basesz;
 	int numents;
 } *inilnk;
 
+static void ilpack(struct ilist *);
+
+/*
+ * Store node n in il.  Plain integer constants for static data are
+ * kept as value and type only.
+ */
+static void
+ilset(struct ilist *il, NODE *n)
+{
+	il->n = n;
+	if (csym->sclass != AUTO)
+		ilpack(il);
+}
+
+static void
+ilpack(struct ilist *il)
+{
+	NODE *n = il->n;
+
+	if (n->n_op != ICON || n->n_sp != NULL)
+		return;
+	if (il->fsz > 0 && (n->n_type < CHAR || n->n_type > ULONGLONG ||
+	    il->fsz != (int)sztable[n->n_type]))
+		return;
+	il->t = n->n_type;
+	il->val = glval(n);
+	il->n = NULL;
+	nfree(n);
+}
+
 static struct ilist *
 getil(struct ilist *next, CONSZ b, int sz, NODE *n)
 {
@@ -175,8 +215,8 @@ getil(struct ilist *next, CONSZ b, int sz, NODE *n)
 
 	il->off = b;
 	il->fsz = sz;
-	il->n = n;
 	il->next = next;
+	ilset(il, n);
 	return il;
 }
 
@@ -187,13 +227,19 @@ getil(struct ilist *next, CONSZ b, int sz, NODE *n)
 static struct llist *
 getll(void)
 {
-	struct llist *ll;
-
+	struct llist *ll, **nl;
+
+	if (numents == llasz) {
+		llasz = llasz ? llasz * 2 : 16;
+		nl = tmpalloc(llasz * sizeof(struct llist *));
+		if (numents)
+			memcpy(nl, llarr, numents * sizeof(struct llist *));
+		llarr = nl;
+	}
 	ll = tmpalloc(sizeof(struct llist));
 	ll->begsz = numents * basesz;
-	ll->il = NULL;
-	SLIST_INSERT_LAST(&lpole, ll, next);
-	numents++;
+	ll->il = ll->last = NULL;
+	llarr[numents++] = ll;
 	return ll;
 }
 
@@ -204,19 +250,11 @@ getll(void)
 static struct llist *
 setll(OFFSZ off)
 {
-	struct llist *ll = NULL;
-
 	/* Ensure that we have enough entries */
 	while (off >= basesz * numents)
-		 ll = getll();
-
-	if (ll != NULL && ll->begsz <= off && ll->begsz + basesz > off)
-		return ll;
+		 (void)getll();
 
-	SLIST_FOREACH(ll, &lpole, next)
-		if (ll->begsz <= off && ll->begsz + basesz > off)
-			break;
-	return ll; /* ``cannot fail'' */
+	return llarr[off / basesz];
 }
 char *astypnames[] = { 0, 0, "\t.byte", "\t.byte", "\t.short", "\t.short",
 	"\t.word", "\t.word", "\t.long", "\t.long", "\t.quad", "\t.quad",
@@ -339,6 +377,20 @@ infld(CONSZ off, int fsz, CONSZ val)
 
 char *asspace = "\t.space";
 
+/*
+ * Whole zero bytes are held back until other data follows, so that
+ * adjacent gaps come out as one space directive.
+ */
+static OFFSZ zpend;
+
+static void
+zflush(void)
+{
+	if (zpend)
+		printf(PRTPREF "%s " CONFMT "\n", asspace, (CONSZ)zpend);
+	zpend = 0;
+}
+
 /*
  * set fsz bits in sequence to zero.
  */
@@ -361,6 +413,7 @@ zbits(OFFSZ off, int fsz)
 		} else {
 			fsz -= m;
 			xinval <<= m;
+			zflush();
 			printf(PRTPREF "%s " CONFMT "\n", 
 			    astypnames[CHAR], (CONSZ)(xinval & SZMASK(SZCHAR)));
 			xinval = inbits = 0;
@@ -374,6 +427,7 @@ zbits(OFFSZ off, int fsz)
 			return;
 		} else {
 			fsz -= m;
+			zflush();
 			printf(PRTPREF "%s " CONFMT "\n", 
 			    astypnames[CHAR], (CONSZ)(xinval & SZMASK(SZCHAR)));
 			xinval = inbits = 0;
@@ -381,7 +435,7 @@ zbits(OFFSZ off, int fsz)
 	}
 #endif
 	if (fsz >= SZCHAR) {
-		printf(PRTPREF "%s " CONFMT "\n", asspace, (CONSZ)(fsz/SZCHAR));
+		zpend += fsz/SZCHAR;
 		fsz -= (fsz/SZCHAR) * SZCHAR;
 	}
 	if (fsz) {
@@ -413,7 +467,8 @@ beginit(struct symtab *sp)
 		inilnk = ict;
 		ict->pstk = pstk;
 		ict->psym = csym;
-		ict->lpole = lpole;
+		ict->llarr = llarr;
+		ict->llasz = llasz;
 		ict->basesz = basesz;
 		ict->numents = numents;
 		is = tmpalloc(sizeof(struct instk));
@@ -421,6 +476,8 @@ beginit(struct symtab *sp)
 	csym = sp;
 
 	numents = 0; /* no entries in array list */
+	llarr = NULL;
+	llasz = 0;
 	if (ISARY(sp->stype)) {
 		basesz = tsize(DECREF(sp->stype), sp->sdf+1, sp->sap);
 		if (basesz == 0) {
@@ -429,7 +486,6 @@ beginit(struct symtab *sp)
 		}
 	} else
 		basesz = tsize(sp->stype, sp->sdf, sp->sap);
-	SLIST_INIT(&lpole);
 
 	/* first element */
 	if (ISSOU(sp->stype)) {
@@ -642,7 +698,10 @@ nsetval(CONSZ off, int fsz, NODE *p)
 	ll = setll(off);
 	off -= ll->begsz;
 	if (ll->il == NULL) {
-		ll->il = getil(NULL, off, fsz, p);
+		ll->il = ll->last = getil(NULL, off, fsz, p);
+	} else if (ll->last->off < off) {
+		/* common case; initializers given in order */
+		ll->last = ll->last->next = getil(NULL, off, fsz, p);
 	} else {
 		il = ll->il;
 		if (il->off > off) {
@@ -653,8 +712,9 @@ nsetval(CONSZ off, int fsz, NODE *p)
 					break;
 			if (il->off == off) {
 				/* replace */
-				nfree(il->n);
-				il->n = p;
+				if (il->n != NULL)
+					nfree(il->n);
+				ilset(il, p);
 			} else
 				il->next = getil(il->next, off, fsz, p);
 		}
@@ -734,10 +794,10 @@ scalinit(NODE *p)
 		fsz = (int)tsize(pstk->in_t, pstk->in_sym->sdf,
 		    pstk->in_sym->sap);
 
-	nsetval(woff, fsz, q);
 	if (q->n_op == ICON && q->n_sp &&
 	    ((q->n_sp->sflags & SMASK) == SSTRING))
 		q->n_sp->sflags |= SASG;
+	nsetval(woff, fsz, q);
 
 	stkpop();
 	ID(("scalinit end(%p)\n", q));
@@ -805,91 +865,309 @@ clearbf(OFFSZ off, OFFSZ fsz)
 }
 
 /*
- * final step of initialization.
- * print out init nodes and generate copy code (if needed).
+ * Runs of packed values are collected here and written out in one go
+ * by inrun().  Trailing zeros are only counted; long enough stretches
+ * of them are written as space instead.
  */
-void
-endinit(int seg)
-{
-	struct llist *ll;
-	struct ilist *il;
-	int fsz;
-	OFFSZ lastoff, tbit;
+#define	NRUN	16		/* max values per inrun() call */
+#define	ZFOLD	(8*SZCHAR)	/* min zero stretch turned into space */
 
-	ID(("endinit()\n"));
+static CONSZ runv[NRUN];
+static CONSZ runoff;	/* bit offset of first value in run */
+static TWORD runt;
+static int nrun, nzero;
 
-	/* Calculate total block size */
-	if (ISARY(csym->stype) && csym->sdf->ddim == NOOFFSET) {
-		tbit = numents*basesz; /* open-ended arrays */
-		csym->sdf->ddim = numents;
-		if (csym->sclass == AUTO) { /* Get stack space */
-			csym->soffset = NOOFFSET;
-			oalloc(csym, &autooff);
+static void
+flushrun(void)
+{
+	int n, sz;
+
+	if (nrun + nzero == 0)
+		return;
+	sz = (int)sztable[runt];
+	if (nrun) {
+		zflush();
+		inrun(runoff, runt, runv, nrun);
+	}
+	runoff += (CONSZ)nrun * sz;
+	if ((CONSZ)nzero * sz >= ZFOLD) {
+		zbits(runoff, nzero * sz);
+	} else {
+		zflush();
+		memset(runv, 0, sizeof(runv));
+		for (; nzero > 0; nzero -= n) {
+			n = nzero > NRUN ? NRUN : nzero;
+			inrun(runoff, runt, runv, n);
+			runoff += (CONSZ)n * sz;
 		}
-	} else
-		tbit = tsize(csym->stype, csym->sdf, csym->sap);
+	}
+	nrun = nzero = 0;
+}
 
-	/* Setup symbols */
-	if (csym->sclass != AUTO) {
-		locctr(seg ? UDATA : DATA, csym);
-		defloc(csym);
+/*
+ * Add a packed value of type t at off to the current run.
+ */
+static void
+putrun(CONSZ off, TWORD t, CONSZ val)
+{
+	int sz = (int)sztable[t];
+
+	if (nrun + nzero && (t != runt ||
+	    off != runoff + (CONSZ)(nrun + nzero) * sz))
+		flushrun();
+	if (nrun + nzero == 0) {
+		runoff = off;
+		runt = t;
+	}
+	if ((val & SZMASK(sz)) == 0) {
+		nzero++;
+		return;
 	}
+	if (nzero || nrun == NRUN)
+		flushrun();
+	if (nrun == 0) {
+		runoff = off;
+		runt = t;
+	}
+	runv[nrun++] = val;
+}
+
+#ifndef MYINRUN
+/*
+ * Print n packed values of type t, starting at off.
+ */
+void
+inrun(CONSZ off, TWORD t, CONSZ *v, int n)
+{
+	NODE *p = bcon(0);
+	int sz = (int)sztable[t];
+
+	for (; n > 0; n--, off += sz) {
+		p->n_type = t;
+		slval(p, *v++);
+		inval(off, sz, p);
+	}
+	nfree(p);
+}
+#endif
+
+/*
+ * Print out the initializer entries as data.  If tmpl is set only
+ * constants are printed and each printed entry is taken off the list;
+ * anything else is left as zero for the caller to store at run-time.
+ */
+static void
+indata(OFFSZ tbit, int tmpl)
+{
+	struct llist *ll;
+	struct ilist *il;
+	int fsz, i;
+	OFFSZ lastoff;
 
-	/* Traverse all entries and print'em out */
 	lastoff = 0;
-	SLIST_FOREACH(ll, &lpole, next) {
+	for (i = 0; i < numents; i++) {
+		ll = llarr[i];
 		for (il = ll->il; il; il = il->next) {
-#ifdef PCC_DEBUG
-			if (idebug > 1) {
-				printf("off " CONFMT " size %d val " CONFMT " type ",
-				    ll->begsz+il->off, il->fsz, glval(il->n));
-				tprint(il->n->n_type, 0);
-				printf("\n");
-			}
-#endif
 			fsz = il->fsz;
-			if (csym->sclass == AUTO) {
-				struct symtab sym;
-				NODE *p, *r, *n;
-
-				if (ll->begsz + il->off > lastoff)
-					clearbf(lastoff,
+			if (tmpl && il->n != NULL) {
+				if (il->n->n_op != ICON && il->n->n_op != FCON)
+					continue;
+				ilpack(il);
+			}
+			if (il->n == NULL && fsz > 0) {
+				if (ll->begsz + il->off > lastoff) {
+					flushrun();
+					zbits(lastoff,
 					    (ll->begsz + il->off) - lastoff);
-
-				/* Fake a struct reference */
-				p = buildtree(ADDROF, nametree(csym), NIL);
-				n = il->n;
-				sym.stype = n->n_type;
-				sym.squal = n->n_qual;
-				sym.sdf = n->n_df;
-				sym.sap = n->n_ap;
-				sym.soffset = (int)(ll->begsz + il->off);
-				sym.sclass = (char)(fsz < 0 ? FIELD | -fsz : 0);
-				r = xbcon(0, &sym, INT);
-				p = block(STREF, p, r, INT, 0, 0);
-				ecomp(buildtree(ASSIGN, stref(p), il->n));
-				if (fsz < 0)
-					fsz = -fsz;
-
+				}
+				putrun(ll->begsz + il->off, il->t, il->val);
 			} else {
+				flushrun();
 				if (ll->begsz + il->off > lastoff)
 					zbits(lastoff,
 					    (ll->begsz + il->off) - lastoff);
+				zflush();
 				if (fsz < 0) {
 					fsz = -fsz;
-					infld(il->off, fsz, glval(il->n));
+					infld(il->off, fsz,
+					    il->n ? glval(il->n) : il->val);
 				} else
 					inval(il->off, fsz, il->n);
-				tfree(il->n);
+				if (il->n)
+					tfree(il->n);
+				il->n = NULL;
 			}
 			lastoff = ll->begsz + il->off + fsz;
 		}
 	}
-	if (csym->sclass == AUTO) {
+	flushrun();
+	zbits(lastoff, tbit-lastoff);
+	zflush();
+}
+
+#ifdef BLKINIT
+/*
+ * An auto aggregate is worth copying from a read-only template if the
+ * template and the copy are smaller than the stores it replaces.
+ * Each store, zeroing of a byte gap included, is taken as three words
+ * of code; BLKINIT is the size of the copy code in bytes.
+ */
+static int
+blkinit(OFFSZ tbit)
+{
+	struct llist *ll;
+	struct ilist *il;
+	OFFSZ lastoff, nst, ncon;
+	int i;
+
+	if (!ISARY(csym->stype) && !ISSOU(csym->stype))
+		return 0;
+	lastoff = nst = ncon = 0;
+	for (i = 0; i < numents; i++) {
+		ll = llarr[i];
+		for (il = ll->il; il; il = il->next) {
+			if (ll->begsz + il->off > lastoff)
+				nst += (ll->begsz + il->off - lastoff +
+				    SZCHAR-1) / SZCHAR;
+			if (il->n->n_op == ICON || il->n->n_op == FCON)
+				ncon++;
+			lastoff = ll->begsz + il->off +
+			    (il->fsz < 0 ? -il->fsz : il->fsz);
+		}
+	}
+	if (tbit > lastoff)
+		nst += (tbit - lastoff + SZCHAR-1) / SZCHAR;
+	if (ncon == 0)
+		return 0;
+	nst += ncon;
+	return tbit/SZCHAR + BLKINIT < nst * 3 * (SZINT/SZCHAR);
+}
+
+/*
+ * Print the constant part of the initializer to a read-only template
+ * and copy it to the auto variable with a block move.
+ */
+static void
+blkcopy(OFFSZ tbit)
+{
+	struct symtab *sp;
+	union dimfun *df;
+	struct attr *ap;
+	NODE *p, *q;
+
+	sp = getsymtab(csym->sname, STEMP);
+	sp->stype = csym->stype;
+	sp->squal = (CON >> TSHIFT);
+	sp->sdf = csym->sdf;
+	sp->sap = csym->sap;
+	sp->sclass = STATIC;
+	sp->slevel = 1;
+	sp->soffset = getlab();
+
+	locctr(DATA, sp);
+	defloc(sp);
+	indata(tbit, 1);
+
+	df = tmpalloc(sizeof(union dimfun));
+	df->ddim = (int)(tbit/SZCHAR);
+	ap = attr_new(ATTR_ALIGNED, 1);
+	ap->iarg(0) = talign(csym->stype, csym->sap);
+	p = buildtree(ADDROF, nametree(csym), NIL);
+	p = block(UMUL, p, NIL, ARY|UCHAR, df, ap);
+	q = buildtree(ADDROF, nametree(sp), NIL);
+	ecomp(block(STASG, p, q, ARY|UCHAR, df, ap));
+}
+#endif
+
+/*
+ * Generate code to initialize an auto variable.
+ */
+static void
+inauto(OFFSZ tbit)
+{
+	struct llist *ll;
+	struct ilist *il;
+	int fsz, i, tmpl;
+	OFFSZ lastoff;
+
+	tmpl = 0;
+#ifdef BLKINIT
+	if (blkinit(tbit)) {
+		blkcopy(tbit);
+		tmpl = 1;
+	}
+#endif
+
+	/* Generate code for the run-time part */
+	lastoff = 0;
+	for (i = 0; i < numents; i++) {
+		ll = llarr[i];
+		for (il = ll->il; il; il = il->next) {
+			struct symtab sym;
+			NODE *p, *r, *n;
+
+			if ((n = il->n) == NULL)
+				continue; /* in the template */
+			fsz = il->fsz;
+			if (!tmpl && ll->begsz + il->off > lastoff)
+				clearbf(lastoff,
+				    (ll->begsz + il->off) - lastoff);
+
+			/* Fake a struct reference */
+			p = buildtree(ADDROF, nametree(csym), NIL);
+			sym.stype = n->n_type;
+			sym.squal = n->n_qual;
+			sym.sdf = n->n_df;
+			sym.sap = n->n_ap;
+			sym.soffset = (int)(ll->begsz + il->off);
+			sym.sclass = (char)(fsz < 0 ? FIELD | -fsz : 0);
+			r = xbcon(0, &sym, INT);
+			p = block(STREF, p, r, INT, 0, 0);
+			ecomp(buildtree(ASSIGN, stref(p), n));
+			if (fsz < 0)
+				fsz = -fsz;
+			lastoff = ll->begsz + il->off + fsz;
+		}
+	}
+	if (!tmpl)
 		clearbf(lastoff, tbit-lastoff);
+}
+
+/*
+ * final step of initialization.
+ * print out init nodes and generate copy code (if needed).
+ */
+void
+endinit(int seg)
+{
+	OFFSZ tbit;
+
+	ID(("endinit()\n"));
+
+	/* Calculate total block size */
+	if (ISARY(csym->stype) && csym->sdf->ddim == NOOFFSET) {
+		tbit = numents*basesz; /* open-ended arrays */
+		csym->sdf->ddim = numents;
+		if (csym->sclass == AUTO) { /* Get stack space */
+			csym->soffset = NOOFFSET;
+			oalloc(csym, &autooff);
+		}
 	} else
-		zbits(lastoff, tbit-lastoff);
-	
+		tbit = tsize(csym->stype, csym->sdf, csym->sap);
+
+#ifdef PCC_DEBUG
+	if (idebug > 1)
+		prtinit();
+#endif
+
+	/* Setup symbols */
+	if (csym->sclass != AUTO) {
+		locctr(seg ? UDATA : DATA, csym);
+		defloc(csym);
+		indata(tbit, 0);
+	} else
+		inauto(tbit);
+
 	doing_init--;
 	if (csym->sclass == STATIC || csym->sclass == EXTDEF)
 		statinit--;
@@ -907,7 +1185,8 @@ endictx(void)
 
 	pstk = ict->pstk;
 	csym = ict->psym;
-	lpole = ict->lpole;
+	llarr = ict->llarr;
+	llasz = ict->llasz;
 	basesz = ict->basesz;
 	numents = ict->numents;
 	inilnk = inilnk->prev;
@@ -1186,6 +1465,25 @@ prtstk(struct instk *in)
 		o++;
 	}
 }
+
+static void
+prtinit(void)
+{
+	struct llist *ll;
+	struct ilist *il;
+	int i;
+
+	for (i = 0; i < numents; i++) {
+		ll = llarr[i];
+		for (il = ll->il; il; il = il->next) {
+			printf("off " CONFMT " size %d val " CONFMT " type ",
+			    ll->begsz+il->off, il->fsz,
+			    il->n ? glval(il->n) : il->val);
+			tprint(il->n ? il->n->n_type : il->t, 0);
+			printf("\n");
+		}
+	}
+}
 #endif
 
 /*
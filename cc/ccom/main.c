@@ -45,9 +45,9 @@ int r2debug, s2debug, t2debug, u2debug, x2debug;
 int gflag, kflag;
 int pflag, sflag;
 int sspflag;
-int xscp, xssa, xtailcall, xtemps, xdeljumps, xdce, xinline, xccp, xgnu89, xgnu99;
-int xuchar;
-int freestanding;
+int xscp, xssa, xspace, xtailcall, xtemps, xdeljumps, xdce, xcse, xloop, xinline, xccp, xgnu89, xgnu99;
+int xuchar, xtextir;
+int freestanding, nobuiltin;
 char *prgname, *ftitle;
 
 static void prtstats(void);
@@ -76,6 +76,8 @@ xopt(char *str)
 {
 	if (strcmp(str, "ssa") == 0)
 		xssa++;
+	else if (strcmp(str, "space") == 0)
+		xspace++;
 	else if (strcmp(str, "tailcall") == 0)
 		xtailcall++;
 	else if (strcmp(str, "temps") == 0)
@@ -84,6 +86,10 @@ xopt(char *str)
 		xdeljumps++;
 	else if (strcmp(str, "dce") == 0)
 		xdce++;
+	else if (strcmp(str, "cse") == 0)
+		xcse++;
+	else if (strcmp(str, "loop") == 0)
+		xloop++;
 	else if (strcmp(str, "inline") == 0)
 		xinline++;
 	else if (strcmp(str, "ccp") == 0)
@@ -96,6 +102,8 @@ xopt(char *str)
 		xgnu99++;
 	else if (strcmp(str, "uchar") == 0)
 		xuchar++;
+	else if (strcmp(str, "textir") == 0)
+		xtextir++;
 	else {
 		fprintf(stderr, "unknown -x option '%s'\n", str);
 		usage();
@@ -121,6 +129,8 @@ fflags(char *str)
 		pragma_allpacked = (strlen(str) > 12 ? atoi(str+12) : 1);
 	else if (strcmp(str, "freestanding") == 0)
 		freestanding = flagval;
+	else if (strcmp(str, "builtin") == 0)
+		nobuiltin = !flagval;
 	else {
 		fprintf(stderr, "unknown -f option '%s'\n", str);
 		usage();
@@ -227,11 +237,11 @@ main(int argc, char *argv[])
 		case 'k': /* PIC code */
 			++kflag;
 			break;
-#ifndef PASS1
 		case 'm': /* Target-specific */
+#ifndef PASS1
 			mflags(optarg);
-			break;
 #endif
+			break;
 		case 'p': /* Profiling */
 			++pflag;
 			break;
@@ -282,6 +292,9 @@ main(int argc, char *argv[])
 		}
 	}
 
+#ifdef PASS1
+	irheader();
+#endif
 	mkdope();
 	signal(SIGSEGV, segvcatch);
 #ifdef SIGBUS
@@ -389,14 +402,17 @@ prtstats(void)
 	extern int arglistcnt, dimfuncnt, inlstatcnt;
 	extern int symtabcnt, suedefcnt, strtabs, strstrlen;
 	extern int blkalloccnt, lcommsz, istatsz;
-	extern int savstringsz, newattrsz, nodesszcnt, symtreecnt;
+	extern int savstringsz, newattrsz, symtreecnt;
 #endif
 	extern size_t permallocsize, tmpallocsize, lostmem;
+	extern int nodesszcnt, noderesets;
 
 	/* common allocations */
 	fprintf(stderr, "Permanent allocated memory:	%zu B\n", permallocsize);
 	fprintf(stderr, "Temporary allocated memory:	%zu B\n", tmpallocsize);
 	fprintf(stderr, "Lost memory:			%zu B\n", lostmem);
+	fprintf(stderr, "Node arena size:		%d B\n", nodesszcnt);
+	fprintf(stderr, "Node arena resets:		%d pcs\n", noderesets);
 
 #ifndef PASS2
 	/* pass1 allocations */
@@ -408,10 +424,10 @@ prtstats(void)
 	fprintf(stderr, "Inline control blocks:		%d pcs\n", inlstatcnt);
 	fprintf(stderr, "Permanent symtab entries:	%d pcs\n", symtabcnt);
 	fprintf(stderr, "\n");
-	fprintf(stderr, "Name table tree size:		%d B\n",
+	fprintf(stderr, "Name table hash size:		%d B\n",
 	    nametabs * treestrsz);
 	fprintf(stderr, "Name string size:		%d B\n", namestrlen);
-	fprintf(stderr, "String table tree size:		%d B\n",
+	fprintf(stderr, "String table hash size:		%d B\n",
 	    strtabs * treestrsz);
 	fprintf(stderr, "String size:			%d B\n", strstrlen);
 	fprintf(stderr, "Inline control block size:	%d B\n",
@@ -422,19 +438,18 @@ prtstats(void)
 	    dimfuncnt * (int)sizeof(union dimfun));
 	fprintf(stderr, "Permanent symtab size:		%d B\n",
 	    symtabcnt * (int)sizeof(struct symtab));
-	fprintf(stderr, "Symtab tree size:		%d B\n",
+	fprintf(stderr, "Symtab hash size:		%d B\n",
 	    symtreecnt * treestrsz);
 	fprintf(stderr, "lcomm struct size:		%d B\n", lcommsz);
 	fprintf(stderr, "blkalloc size:			%d B\n", blkalloccnt);
 	fprintf(stderr, "(saved strings size):		%d B\n", savstringsz);
 	fprintf(stderr, "attribute size:			%d B\n", newattrsz);
-	fprintf(stderr, "nodes size:			%d B\n", nodesszcnt);
 	fprintf(stderr, "\n");
 	fprintf(stderr, "Not accounted for:		%d B\n",
 	    (int)permallocsize-(nametabs * treestrsz)-namestrlen-strstrlen-
 	    (arglistcnt * (int)sizeof(union arglist))-(strtabs * treestrsz)-
 	    (dimfuncnt * (int)sizeof(union dimfun))-(inlstatcnt * istatsz)-
 	    (symtabcnt * (int)sizeof(struct symtab))-(symtreecnt * treestrsz)-
-	    lcommsz-blkalloccnt-newattrsz-nodesszcnt);
+	    lcommsz-blkalloccnt-newattrsz);
 #endif
 }
@@ -166,6 +166,7 @@ struct swents {			/* switch table */
 	int	slab;		/* associated label */
 };
 int mygenswitch(int, TWORD, struct swents **, int);
+void savlab(int);
 
 extern	int blevel;
 extern	int oldstyle;
@@ -180,7 +181,7 @@ extern	OFFSZ inoff;
 
 extern	int reached;
 extern	int isinlining;
-extern	int xinline, xgnu89, xgnu99;
+extern	int xinline, xgnu89, xgnu99, freestanding, nobuiltin;
 extern	int bdebug, ddebug, edebug, idebug, ndebug;
 extern	int odebug, pdebug, sdebug, tdebug, xdebug;
 
@@ -342,6 +343,7 @@ TWORD ctype(TWORD);
 void inval(CONSZ, int, P1ND *);
 int ninval(CONSZ, int, P1ND *);
 void infld(CONSZ, int, CONSZ);
+void inrun(CONSZ, TWORD, CONSZ *, int);
 void zbits(CONSZ, int);
 void instring(struct symtab *);
 void inwstring(struct symtab *);
@@ -376,6 +378,9 @@ int mypragma(char *);
 char *pragtok(char *);
 int eat(int);
 void fixdef(struct symtab *);
+#ifdef TARGET_DECLEND
+void target_declend(void);
+#endif
 int cqual(TWORD, TWORD);
 void defloc(struct symtab *);
 int fldchk(int);
@@ -404,6 +409,9 @@ void defid(P1ND *q, int class);
 void defid2(P1ND *q, int class, char *astr);
 void efcode(void);
 void ecomp(P1ND *p);
+#ifdef PASS1
+void irheader(void);
+#endif
 int upoff(int size, int alignment, int *poff);
 void nidcl(P1ND *p, int class);
 void nidcl2(P1ND *p, int class, char *astr);
@@ -602,12 +610,20 @@ struct bitable {
 };
 
 P1ND *builtin_check(struct symtab *, P1ND *a);
+struct symtab *builtin_lib(struct symtab *);
 void builtin_init(void);
 
 /* Some builtins targets need to implement */
 P1ND *builtin_frame_address(const struct bitable *bt, P1ND *a);
 P1ND *builtin_return_address(const struct bitable *bt, P1ND *a);
 P1ND *builtin_cfa(const struct bitable *bt, P1ND *a);
+#ifdef TARGET_MEMCPY
+P1ND *builtin_memcpy(const struct bitable *bt, P1ND *a);
+#endif
+#ifdef TARGET_MEMSET
+P1ND *builtin_memset(const struct bitable *bt, P1ND *a);
+#endif
+P1ND *binhelp(P1ND *a, TWORD rt, char *n);
 #endif
 
 
@@ -35,161 +35,120 @@
 #define	fwalk p1fwalk
 
 /*
- * These definitions are used in the patricia tree that stores
- * the strings.
+ * Names, strings and global symbols are kept in hash tables.
+ * A name or string is entered only once, so the address of the
+ * saved string identifies it and global symbols are hashed on
+ * that address.  The tables double in size when they get full.
  */
-#define	LEFT_IS_LEAF		0x80000000
-#define	RIGHT_IS_LEAF		0x40000000
-#define	IS_LEFT_LEAF(x)		(((x) & LEFT_IS_LEAF) != 0)
-#define	IS_RIGHT_LEAF(x)	(((x) & RIGHT_IS_LEAF) != 0)
-#define	BITNO(x)		((x) & ~(LEFT_IS_LEAF|RIGHT_IS_LEAF))
-#define	CHECKBITS		8
-
-struct tree {
-	int bitno;
-	struct tree *lr[2];
+struct hent {
+	struct hent *next;
+	void *ptr;		/* saved string or struct symtab */
+	unsigned int hash;
 };
 
+struct htab {
+	struct hent **tab;
+	unsigned int size;	/* number of buckets, power of 2 */
+	unsigned int num;	/* number of entries */
+};
+
+#define	HTINIT		256	/* initial table size */
+#define	SYMHASH(key)	((unsigned int)((uintptr_t)(key) ^ \
+	((uintptr_t)(key) >> 4) ^ ((uintptr_t)(key) >> 12)))
+
 extern int dimfuncnt;
-static struct tree *firstname;
+static struct htab names, strings;
 int nametabs, namestrlen;
-static struct tree *firststr;
 int strtabs, strstrlen, symtreecnt;
-static char *symtab_add(char *key, struct tree **, int *, int *);
+static char *symtab_add(char *key, struct htab *, int *, int *);
 int lastloc = NOSEG;
-int treestrsz = sizeof(struct tree);
+int treestrsz = sizeof(struct hent);
 
-#define	P_BIT(key, bit) (key[bit >> 3] >> (bit & 7)) & 1
-#define	getree() permalloc(sizeof(struct tree))
+/*
+ * Return the bucket for hash, growing the table if needed.
+ */
+static struct hent **
+hbucket(struct htab *ht, unsigned int hash)
+{
+	struct hent **tab, *h, *next;
+	unsigned int i, size;
+
+	if (ht->num >= 2 * ht->size) {
+		size = ht->size ? ht->size * 2 : HTINIT;
+		tab = xcalloc(size, sizeof(struct hent *));
+		for (i = 0; i < ht->size; i++) {
+			for (h = ht->tab[i]; h; h = next) {
+				next = h->next;
+				h->next = tab[h->hash & (size-1)];
+				tab[h->hash & (size-1)] = h;
+			}
+		}
+		free(ht->tab);
+		ht->tab = tab;
+		ht->size = size;
+	}
+	return &ht->tab[hash & (ht->size-1)];
+}
 
 char *
 addname(char *key)      
 {
-	return symtab_add(key, &firstname, &nametabs, &namestrlen);
+	return symtab_add(key, &names, &nametabs, &namestrlen);
 }
 
 char *
 addstring(char *key)
 {
-	return symtab_add(key, &firststr, &strtabs, &strstrlen);
+	return symtab_add(key, &strings, &strtabs, &strstrlen);
 }
 
 /*
- * Add a name to the name stack (if its non-existing),
+ * Add a name to the name table (if its non-existing),
  * return its address.
- * This is a simple patricia implementation.
  */
 static char *
-symtab_add(char *key, struct tree **first, int *tabs, int *stlen)
+symtab_add(char *key, struct htab *ht, int *tabs, int *stlen)
 {
-	struct tree *w, *new, *last;
-	int cix, bit, fbit, svbit, ix, bitno, len;
-	char *m, *k, *sm;
-
-	/* Count full string length */
-	for (k = key, len = 0; *k; k++, len++)
-		;
-	
-	switch (*tabs) {
-	case 0:
-		*first = (struct tree *)newstring(key, len);
-		*stlen += (len + 1);
-		(*tabs)++;
-		return (char *)*first;
-
-	case 1:
-		m = (char *)*first;
-		svbit = 0; /* XXX why? */
-		break;
-
-	default:
-		w = *first;
-		bitno = len * CHECKBITS;
-		for (;;) {
-			bit = BITNO(w->bitno);
-			fbit = bit > bitno ? 0 : P_BIT(key, bit);
-			svbit = fbit ? IS_RIGHT_LEAF(w->bitno) :
-			    IS_LEFT_LEAF(w->bitno);
-			w = w->lr[fbit];
-			if (svbit) {
-				m = (char *)w;
-				break;
-			}
-		}
-	}
-
-	sm = m;
-	k = key;
-
-	/* Check for correct string and return */
-	for (cix = 0; *m && *k && *m == *k; m++, k++, cix += CHECKBITS)
-		;
-	if (*m == 0 && *k == 0)
-		return sm;
-
-	ix = *m ^ *k;
-	while ((ix & 1) == 0)
-		ix >>= 1, cix++;
-
-	/* Create new node */
-	new = getree();
-	bit = P_BIT(key, cix);
-	new->bitno = cix | (bit ? RIGHT_IS_LEAF : LEFT_IS_LEAF);
-	new->lr[bit] = (struct tree *)newstring(key, len);
+	struct hent *h, **hp;
+	unsigned int hash;
+	char *k;
+	int len;
+
+	/* Hash and count full string length at once */
+	for (k = key, hash = 0; *k; k++)
+		hash = hash * 31 + (unsigned char)*k;
+	len = (int)(k - key);
+
+	hp = hbucket(ht, hash);
+	for (h = *hp; h; h = h->next)
+		if (h->hash == hash && strcmp(h->ptr, key) == 0)
+			return h->ptr;
+
+	h = permalloc(sizeof(struct hent));
+	h->ptr = newstring(key, len);
+	h->hash = hash;
+	h->next = *hp;
+	*hp = h;
+	ht->num++;
 	*stlen += (len + 1);
-
-	if ((*tabs)++ == 1) {
-		new->lr[!bit] = *first;
-		new->bitno |= (bit ? LEFT_IS_LEAF : RIGHT_IS_LEAF);
-		*first = new;
-		return (char *)new->lr[bit];
-	}
-
-
-	w = *first;
-	last = NULL;
-	for (;;) {
-		fbit = w->bitno;
-		bitno = BITNO(w->bitno);
-		if (bitno == cix)
-			cerror("bitno == cix");
-		if (bitno > cix)
-			break;
-		svbit = P_BIT(key, bitno);
-		last = w;
-		w = w->lr[svbit];
-		if (fbit & (svbit ? RIGHT_IS_LEAF : LEFT_IS_LEAF))
-			break;
-	}
-
-	new->lr[!bit] = w;
-	if (last == NULL) {
-		*first = new;
-	} else {
-		last->lr[svbit] = new;
-		last->bitno &= ~(svbit ? RIGHT_IS_LEAF : LEFT_IS_LEAF);
-	}
-	if (bitno < cix)
-		new->bitno |= (bit ? LEFT_IS_LEAF : RIGHT_IS_LEAF);
-	return (char *)new->lr[bit];
+	(*tabs)++;
+	return h->ptr;
 }
 
-static struct tree *sympole[NSTYPES];
+static struct htab symtabs[NSTYPES];
 static struct symtab *tmpsyms[NSTYPES];
 int numsyms[NSTYPES];
 
 /*
- * Inserts a symbol into the symbol tree.
+ * Inserts a symbol into the symbol table.
  * Returns a struct symtab.
  */
 struct symtab *
 lookup(char *key, int stype)
 {
 	struct symtab *sym;
-	struct tree *w, *new, *last;
-	int cix, bit, fbit, svbit, bitno;
+	struct hent *h, **hp;
 	int type, uselvl;
-	intptr_t ix, match, code = (intptr_t)key;
 
 	type = stype & SMASK;
 	uselvl = (blevel > 0 && type != SSTRING);
@@ -203,47 +162,13 @@ lookup(char *key, int stype)
 			if (sym->sname == key)
 				return sym;
 
-	switch (numsyms[type]) {
-	case 0:
-		if (stype & SNOCREAT)
-			return NULL;
-		if (uselvl) {
-			if (type == SNORMAL)
-				stype |= SBLK;
-			sym = getsymtab(key, stype);
-			sym->snext = tmpsyms[type];
-			tmpsyms[type] = sym;
+	hp = hbucket(&symtabs[type], SYMHASH(key));
+	for (h = *hp; h; h = h->next) {
+		sym = h->ptr;
+		if (sym->sname == key)
 			return sym;
-		}
-		sympole[type] = (struct tree *)getsymtab(key, stype);
-		numsyms[type]++;
-		return (struct symtab *)sympole[type];
-
-	case 1:
-		w = (struct tree *)sympole[type];
-		svbit = 0; /* XXX why? */
-		break;
-
-	default:
-		w = sympole[type];
-		for (;;) {
-			bit = BITNO(w->bitno);
-			fbit = (int)(code >> bit) & 1;
-			svbit = fbit ? IS_RIGHT_LEAF(w->bitno) :
-			    IS_LEFT_LEAF(w->bitno);
-			w = w->lr[fbit];
-			if (svbit)
-				break;
-		}
 	}
-
-	sym = (struct symtab *)w;
-	match = (intptr_t)sym->sname;
-
-	ix = code ^ match;
-	if (ix == 0)
-		return sym;
-	else if (stype & SNOCREAT)
+	if (stype & SNOCREAT)
 		return NULL;
 
 #ifdef PCC_DEBUG
@@ -263,55 +188,23 @@ lookup(char *key, int stype)
 	}
 
 	/*
-	 * Need a new node. If type is SNORMAL and inside a function
-	 * the node must be allocated as permanent anyway.
+	 * Need a new entry. If type is SNORMAL and inside a function
+	 * the symbol must be allocated as permanent anyway.
 	 * This could be optimized by adding a remove routine, but it
 	 * may be more trouble than it is worth.
 	 */
 	if (stype == (STEMP|SNORMAL))
 		stype = SNORMAL;
 
-	for (cix = 0; (ix & 1) == 0; ix >>= 1, cix++)
-		;
-
-	new = (symtreecnt++, permalloc(sizeof(struct tree)));
-	bit = (int)(code >> cix) & 1;
-	new->bitno = cix | (bit ? RIGHT_IS_LEAF : LEFT_IS_LEAF);
-	new->lr[bit] = (struct tree *)getsymtab(key, stype);
-	if (numsyms[type]++ == 1) {
-		new->lr[!bit] = sympole[type];
-		new->bitno |= (bit ? LEFT_IS_LEAF : RIGHT_IS_LEAF);
-		sympole[type] = new;
-		return (struct symtab *)new->lr[bit];
-	}
-
-
-	w = sympole[type];
-	last = NULL;
-	for (;;) {
-		fbit = w->bitno;
-		bitno = BITNO(w->bitno);
-		if (bitno == cix)
-			cerror("bitno == cix");
-		if (bitno > cix)
-			break;
-		svbit = (int)(code >> bitno) & 1;
-		last = w;
-		w = w->lr[svbit];
-		if (fbit & (svbit ? RIGHT_IS_LEAF : LEFT_IS_LEAF))
-			break;
-	}
-
-	new->lr[!bit] = w;
-	if (last == NULL) {
-		sympole[type] = new;
-	} else {
-		last->lr[svbit] = new;
-		last->bitno &= ~(svbit ? RIGHT_IS_LEAF : LEFT_IS_LEAF);
-	}
-	if (bitno < cix)
-		new->bitno |= (bit ? LEFT_IS_LEAF : RIGHT_IS_LEAF);
-	return (struct symtab *)new->lr[bit];
+	sym = getsymtab(key, stype);
+	h = (symtreecnt++, permalloc(sizeof(struct hent)));
+	h->ptr = sym;
+	h->hash = SYMHASH(key);
+	h->next = *hp;
+	*hp = h;
+	symtabs[type].num++;
+	numsyms[type]++;
+	return sym;
 }
 
 void
@@ -2764,6 +2764,188 @@ p2print(NODE *p)
 		p2print(p->n_right);
 }
 
+/*
+ * Binary output, see IR_MAGIC in manifest.h.
+ */
+static void
+irnum(U_CONSZ v)
+{
+	while (v >= 0200) {
+		putchar((int)(v & 0177) | 0200);
+		v >>= 7;
+	}
+	putchar((int)v);
+}
+
+static void
+irsnum(CONSZ v)
+{
+	irnum(v < 0 ? ~((U_CONSZ)v << 1) : (U_CONSZ)v << 1);
+}
+
+static void
+irbytes(char *s)
+{
+	int l = strlen(s);
+
+	irnum(l);
+	fwrite(s, 1, l, stdout);
+}
+
+/*
+ * Names are sent once and then referred to by their index.
+ */
+#define	IRSHASH	1024
+
+static struct irstr {
+	struct irstr *next;
+	char *s;
+	int idx;
+} *irshash[IRSHASH];
+static int nirstr;
+
+static void
+irname(char *s)
+{
+	struct irstr *is;
+	unsigned int h = 0;
+	char *t;
+
+	for (t = s; *t; t++)
+		h = h * 31 + (unsigned char)*t;
+	h %= IRSHASH;
+	for (is = irshash[h]; is; is = is->next)
+		if (strcmp(is->s, s) == 0) {
+			irnum(is->idx);
+			return;
+		}
+	is = xmalloc(sizeof(struct irstr));
+	is->s = xstrdup(s);
+	is->idx = ++nirstr;
+	is->next = irshash[h];
+	irshash[h] = is;
+	irnum(0);
+	irbytes(s);
+}
+
+static int
+ircount(NODE *p)
+{
+	int ty = optype(p->n_op);
+
+	if (ty == LTYPE)
+		return 1;
+	if (ty == UTYPE)
+		return 1 + ircount(p->n_left);
+	return 1 + ircount(p->n_left) + ircount(p->n_right);
+}
+
+static void
+irnode(NODE *p)
+{
+	struct attr *ap;
+	int ty, i;
+
+again:	ty = optype(p->n_op);
+	irnum(p->n_op);
+	irnum(p->n_type);
+	irnum(p->n_qual);
+	if (ty == LTYPE)
+		irsnum(glval(p));
+	if (ty != BITYPE && p->n_op != NAME && p->n_op != ICON)
+		irsnum(p->n_rval);
+	if (p->n_op == NAME || p->n_op == ICON ||
+	    p->n_op == XASM || p->n_op == XARG)
+		irname(p->n_name);
+	for (i = 0, ap = p->n_ap; ap; ap = ap->next)
+		i++;
+	irnum(i);
+	for (ap = p->n_ap; ap; ap = ap->next) {
+		irnum(ap->atype);
+		irnum(ap->sz);
+		for (i = 0; i < ap->sz; i++)
+			irsnum(ap->iarg(i));
+	}
+	if (ty == LTYPE)
+		return;
+	if (ty == BITYPE)
+		irnode(p->n_left);
+	p = ty == BITYPE ? p->n_right : p->n_left;
+	goto again;
+}
+
+static void
+irpass(struct interpass *ip)
+{
+	struct interpass_prolog *ipp;
+	int i;
+
+	switch (ip->type) {
+	case IP_PROLOG:
+		ipp = (struct interpass_prolog *)ip;
+		putchar(IR_PROLOG);
+		irnum(ipp->ipp_type);
+		irsnum(ipp->ipp_vis);
+		irsnum(ip->ip_lbl);
+		irsnum(ipp->ip_tmpnum);
+		irsnum(ipp->ip_lblnum);
+		irname(ipp->ipp_name);
+#ifdef TARGET_IPP_MEMBERS
+		printf("( ");
+		target_members_print_prolog(ipp);
+		printf("\n");
+#endif
+		break;
+	case IP_NODE:
+		putchar(IR_NODE);
+		irnum(ircount(ip->ip_node));
+		irnode(ip->ip_node);
+		tfree(ip->ip_node);
+		break;
+	case IP_DEFLAB:
+		putchar(IR_DEFLAB);
+		irsnum(ip->ip_lbl);
+		break;
+	case IP_ASM:
+		putchar(IR_ASM);
+		irbytes(ip->ip_asm);
+		break;
+	case IP_EPILOG:
+		ipp = (struct interpass_prolog *)ip;
+		putchar(IR_EPILOG);
+		irsnum(ipp->ipp_autos);
+		irsnum(ip->ip_lbl);
+		irsnum(ipp->ip_tmpnum);
+		irsnum(ipp->ip_lblnum);
+		irname(ipp->ipp_name);
+		for (i = 0; ipp->ip_labels[i]; i++)
+			;
+		irnum(i);
+		for (i = 0; ipp->ip_labels[i]; i++)
+			irsnum(ipp->ip_labels[i]);
+#ifdef TARGET_IPP_MEMBERS
+		printf(") ");
+		target_members_print_epilog(ipp);
+		printf("\n");
+#endif
+		break;
+	default:
+		cerror("Missing %d", ip->type);
+	}
+}
+
+/*
+ * Start of the pass2 input.  Nothing to tell for the text format.
+ */
+void
+irheader(void)
+{
+	if (xtextir)
+		return;
+	fputs(IR_MAGIC, stdout);
+	irnum(IR_VERSION);
+}
+
 /*
  * Print out the code trees for pass2.
  * First on line is always a sync char, second is space:
@@ -2775,6 +2957,8 @@ p2print(NODE *p)
  *	# - Line number
  *	& - File name
  *	* - Passthrough line.
+ * Unless -xtextir is given the same is sent as binary records by
+ * irpass(), only passthrough and target member lines are left as text.
  */
 void
 pass2_compile(struct interpass *ip)
@@ -2783,8 +2967,21 @@ pass2_compile(struct interpass *ip)
 	static int oldlineno;
 	int i;
 
-	if (oldlineno != ip->lineno)
-		printf("# %d\n", oldlineno = ip->lineno);
+	if (oldlineno != ip->lineno) {
+		oldlineno = ip->lineno;
+		if (xtextir)
+			printf("# %d\n", oldlineno);
+		else {
+			putchar(IR_LINE);
+			irnum(oldlineno);
+		}
+	}
+
+	if (xtextir == 0) {
+		irpass(ip);
+		free(ip);
+		return;
+	}
 
 	switch (ip->type) {
 	case IP_PROLOG:
@@ -2854,13 +3051,30 @@ sptostr(struct symtab *sp)
 	return cp;
 }
 
+/*
+ * Size in bytes of an array with all dimensions known, else 0.
+ */
+static int
+arysize(struct symtab *sp)
+{
+	union dimfun *d;
+	TWORD t;
+
+	if (!ISARY(sp->stype))
+		return 0;
+	for (t = sp->stype, d = sp->sdf; ISARY(t); t = DECREF(t), d++)
+		if (d->ddim <= 0)
+			return 0;
+	return (int)(tsize(sp->stype, sp->sdf, sp->sap)/SZCHAR);
+}
+
 static NODE *
 p2tree(P1ND *p)
 {
 	struct attr *ap;
 	struct symtab *q;
 	NODE *np;
-	int ty;
+	int ty, sz;
 
 	myp2tree(p);  /* local action can be taken here */
 
@@ -2901,6 +3115,12 @@ p2tree(P1ND *p)
 					q->sflags |= SASG;
 			} else
 				np->n_name = getexname(q);
+			/* tell the loop optimizer how far the array goes */
+			if (p->n_op == ICON && (sz = arysize(q)) > 0) {
+				ap = attr_new(ATTR_P2ARRAY, 1);
+				ap->iarg(0) = sz;
+				np->n_ap = attr_add(np->n_ap, ap);
+			}
 		} else
 			np->n_name = "";
 		break;
@@ -2915,8 +3135,11 @@ p2tree(P1ND *p)
 		if (p->n_op == STASG && ISARY(p->n_type)) {
 			int size1 = (int)tsize(p->n_type, p->n_left->n_df,
 			    p->n_left->n_ap)/SZCHAR;
-			ap->iarg(0) = (int)tsize(p->n_type, p->n_right->n_df,
-			    p->n_right->n_ap)/SZCHAR;
+			ap->iarg(0) = size1;
+			/* block copies and fills have no size on the right */
+			if (ISARY(p->n_right->n_type))
+				ap->iarg(0) = (int)tsize(p->n_type,
+				    p->n_right->n_df, p->n_right->n_ap)/SZCHAR;
 			if (size1 < ap->iarg(0))
 				ap->iarg(0) = size1;
 			ap->iarg(1) = talign(p->n_type,
@@ -1044,7 +1044,7 @@ define(void)
 		goto bad;
 
 	dp = readid(c);
-	np = lookup(dp, ENTER);
+	np = hlookup(dp, idhash, ENTER);
 	if (np->valoff) {
 		redef = 1;
 	} else {
@@ -2409,6 +2409,8 @@ cntline(void)
 void
 putch(register int ch)
 {
+	if (gtrack && !ISWSNL(ch))
+		NOGUARD();
 	if (skpows) {
 		if (ch == '\n')
 			skpows++;
@@ -2432,6 +2434,8 @@ putch(register int ch)
 void
 putstr(const usch *s)
 {
+	if (gtrack)
+		NOGUARD();
 	if (skpows)
 		cntline();
 	while (*s) {
@@ -2531,29 +2535,23 @@ usage(void)
 #endif
 
 /*
- * This patricia implementation is more-or-less the same as
- * used in ccom for string matching.
+ * Macro names are kept in a hash table that grows when needed.
+ * Most identifiers are not macros, so a bloom filter over all
+ * entered names is checked first and answers most misses without
+ * looking in the table.
  */
-struct tree {
-	int bitno;
-	struct tree *lr[2];
-};
-
-#define BITNO(x)		((x) & ~(LEFT_IS_LEAF|RIGHT_IS_LEAF))
 #ifdef pdp11
-#define LEFT_IS_LEAF		0x8000
-#define RIGHT_IS_LEAF		0x4000
+#define	BLOOMSZ		(1 << 12)	/* bits in the bloom filter */
 #else
-#define LEFT_IS_LEAF		0x80000000
-#define RIGHT_IS_LEAF		0x40000000
+#define	BLOOMSZ		(1 << 16)
 #endif
-#define IS_LEFT_LEAF(x)		(((x) & LEFT_IS_LEAF) != 0)
-#define IS_RIGHT_LEAF(x)	(((x) & RIGHT_IS_LEAF) != 0)
-#define P_BIT(key, bit)		(key[bit >> 3] >> (bit & 7)) & 1
-#define CHECKBITS		8
+#define	BLOOM1(h)	((h) & (BLOOMSZ-1))
+#define	BLOOM2(h)	(((h) >> 13) & (BLOOMSZ-1))
+#define	HASHINIT	256	/* initial number of buckets */
 
-static struct tree *sympole;
-static int numsyms;
+static unsigned char bloom[BLOOMSZ/8];
+static struct symtab **symhash;
+static int symhsz, numsyms;
 
 /*
  * Allocate a symtab struct and store the string.
@@ -2573,108 +2571,90 @@ getsymtab(const usch *str)
 }
 
 /*
- * Do symbol lookup in a patricia tree.
- * Only do full string matching, no pointer optimisations.
+ * Hash the identifier at key.  Must match the hash done in readid().
  */
-struct symtab *
-lookup(register const usch *key, int enterf)
+unsigned int
+hashid(register const usch *key)
 {
-	struct symtab *sp;
-	register struct tree *w, *new, *last;
-	int len, cix, bit, fbit, svbit, ix, bitno;
-	const usch *k, *m;
-
-	/* Count full string length */
-	for (k = key, len = 0; ISID(*k); k++, len++)
-		;
+	register unsigned int h = IDHASH0;
 
-	switch (numsyms) {
-	case 0: /* no symbols yet */
-		if (enterf != ENTER)
-			return NULL;
-		sympole = (struct tree *)getsymtab(key);
-		numsyms++;
-		return (struct symtab *)sympole;
-
-	case 1:
-		w = sympole;
-		svbit = 0; /* XXX gcc */
-		break;
+	while (ISID(*key))
+		h = IDHASH(h, *key++);
+	return h;
+}
 
-	default:
-		w = sympole;
-		bitno = len * CHECKBITS;
-		for (;;) {
-			bit = BITNO(w->bitno);
-			fbit = bit >= bitno ? 0 : P_BIT(key, bit);
-			svbit = fbit ? IS_RIGHT_LEAF(w->bitno) :
-			    IS_LEFT_LEAF(w->bitno);
-			w = w->lr[fbit];
-			if (svbit)
-				break;
+/*
+ * Double the hash table size and rehash all symbols.
+ */
+static void
+symgrow(void)
+{
+	struct symtab **nh, *sp, *nsp;
+	int i, nsz;
+
+	nsz = symhsz ? symhsz * 2 : HASHINIT;
+	nh = xmalloc(nsz * sizeof(struct symtab *));
+	memset(nh, 0, nsz * sizeof(struct symtab *));
+	for (i = 0; i < symhsz; i++) {
+		for (sp = symhash[i]; sp; sp = nsp) {
+			nsp = sp->hnext;
+			sp->hnext = nh[sp->hash & (nsz-1)];
+			nh[sp->hash & (nsz-1)] = sp;
 		}
 	}
+	if (symhash)
+		free(symhash);
+	symhash = nh;
+	symhsz = nsz;
+}
 
-	sp = (struct symtab *)w;
-
-	m = sp->namep;
-	k = key;
-
-	/* Check for correct string and return */
-	for (cix = 0; *m && ISID(*k) && *m == *k; m++, k++, cix += CHECKBITS)
-		;
-	if (*m == 0 && ISID(*k) == 0) {
-		if (enterf != ENTER && sp->valoff == 0)
-			return NULL;
-		return sp;
-	}
-
-	if (enterf != ENTER)
-		return NULL; /* no string found and do not enter */
-
-	ix = *m ^ *k;
-	while ((ix & 1) == 0)
-		ix >>= 1, cix++;
-
-	/* Create new node */
-	new = addblock(sizeof(*new));
-	bit = P_BIT(key, cix);
-	new->bitno = cix | (bit ? RIGHT_IS_LEAF : LEFT_IS_LEAF);
-	new->lr[bit] = (struct tree *)getsymtab(key);
+/*
+ * Do symbol lookup with an already computed hash.
+ * Only do full string matching, no pointer optimisations.
+ */
+struct symtab *
+hlookup(register const usch *key, unsigned int h, int enterf)
+{
+	register struct symtab *sp;
+	register const usch *k, *m;
 
-	if (numsyms++ == 1) {
-		new->lr[!bit] = sympole;
-		new->bitno |= (bit ? LEFT_IS_LEAF : RIGHT_IS_LEAF);
-		sympole = new;
-		return (struct symtab *)new->lr[bit];
+	if ((bloom[BLOOM1(h) >> 3] & (1 << (BLOOM1(h) & 7))) == 0 ||
+	    (bloom[BLOOM2(h) >> 3] & (1 << (BLOOM2(h) & 7))) == 0) {
+		if (enterf != ENTER)
+			return NULL; /* never entered */
+	} else {
+		for (sp = symhash[h & (symhsz-1)]; sp; sp = sp->hnext) {
+			if (sp->hash != h)
+				continue;
+			/* Check for correct string */
+			for (m = sp->namep, k = key; *m && *m == *k; m++, k++)
+				;
+			if (*m == 0 && ISID(*k) == 0) {
+				if (enterf != ENTER && sp->valoff == 0)
+					return NULL;
+				return sp;
+			}
+		}
+		if (enterf != ENTER)
+			return NULL; /* no string found and do not enter */
 	}
 
-	w = sympole;
-	last = NULL;
-	for (;;) {
-		fbit = w->bitno;
-		bitno = BITNO(w->bitno);
-		if (bitno == cix)
-			error("bitno == cix");
-		if (bitno > cix)
-			break;
-		svbit = P_BIT(key, bitno);
-		last = w;
-		w = w->lr[svbit];
-		if (fbit & (svbit ? RIGHT_IS_LEAF : LEFT_IS_LEAF))
-			break;
-	}
+	if (numsyms >= symhsz)
+		symgrow();
+	sp = getsymtab(key);
+	sp->hash = h;
+	sp->hnext = symhash[h & (symhsz-1)];
+	symhash[h & (symhsz-1)] = sp;
+	numsyms++;
+	bloom[BLOOM1(h) >> 3] |= (1 << (BLOOM1(h) & 7));
+	bloom[BLOOM2(h) >> 3] |= (1 << (BLOOM2(h) & 7));
+	return sp;
+}
 
-	new->lr[!bit] = w;
-	if (last == NULL) {
-		sympole = new;
-	} else {
-		last->lr[svbit] = new;
-		last->bitno &= ~(svbit ? RIGHT_IS_LEAF : LEFT_IS_LEAF);
-	}
-	if (bitno < cix)
-		new->bitno |= (bit ? LEFT_IS_LEAF : RIGHT_IS_LEAF);
-	return (struct symtab *)new->lr[bit];
+struct symtab *
+lookup(const usch *key, int enterf)
+{
+	return hlookup(key, hashid(key), enterf);
 }
 
 void *
@@ -163,6 +163,9 @@ struct includ {
 	int idx;
 	void *incs;
 	const usch *fn;
+	struct symtab *guard;	/* include guard macro */
+	int gstate, gdepth;	/* include guard detection */
+	int once;		/* #pragma once seen */
 #if LIBVMF
 	struct vseg *vseg;
 #endif
@@ -170,20 +173,34 @@ struct includ {
 #define INCINC 0
 #define SYSINC 1
 
+/* include guard states, only whitespace may be output in GS_START/GS_END */
+#define	GS_START	0	/* nothing seen yet */
+#define	GS_IN		1	/* inside #ifndef guard */
+#define	GS_END		2	/* after the #endif of the guard */
+#define	GS_NONE		3	/* not a guarded file */
+#define	NOGUARD()	(gtrack = 0, ifiles->gstate = GS_NONE)
+extern int gtrack;
+
 extern struct includ *ifiles;
 extern usch *pbeg, *pend, *outp, *inp;
 
 /* Symbol table entry  */
 struct symtab {
+	struct symtab *hnext;	/* hash chain */
 	const usch *namep;
 	mvtyp valoff;
 	const usch *file;
 	int line;
+	unsigned int hash;	/* of namep */
 	char type:4,	/* macro type */
 	      wraps:1;	/* macro wraps in buffer */
 	unsigned char narg;	/* # of args (if feasible) */
 };
 
+/* identifier hash (FNV-1a) */
+#define	IDHASH0		2166136261U
+#define	IDHASH(h, c)	(((h) ^ (c)) * 16777619U)
+
 /*
  * Struct used in parse tree evaluation.
  * op is one of:
@@ -210,6 +227,8 @@ enum { NUMBER = 257, UNUMBER, LS, RS, EQ, NE, STRING, WSPACE, CMNT, IDENT,
 #define	SLO_IGNOREWS	001
 
 struct symtab *lookup(const usch *namep, int enterf);
+struct symtab *hlookup(const usch *namep, unsigned int h, int enterf);
+unsigned int hashid(const usch *namep);
 struct blocker;
 struct iobuf *submac(struct symtab *nl, int, struct iobuf *, int);
 struct iobuf *kfind(struct symtab *nl);
@@ -238,6 +257,7 @@ int inc2(void);
 void Ccmnt2(struct iobuf *, int);
 usch *bufid(int ch, struct iobuf *);
 usch *readid(int ch);
+extern unsigned int idhash;
 void faststr(int bc, struct iobuf *);
 void *xrealloc(void *p, int sz);
 void *xmalloc(int sz);
@@ -84,6 +84,7 @@
 #include <unistd.h>
 #endif
 #include <fcntl.h>
+#include <sys/stat.h>
 
 #ifndef pdp11
 #include "compat.h"
@@ -115,6 +116,8 @@ int escln;
 
 struct includ *ifiles;
 usch *pbeg, *outp, *inp, *pend;
+int gtrack;	/* watch output for include guard detection */
+static int gprev;
 
 /* used by yylex() buffer expansion */
 static struct iobuf *lb;
@@ -651,22 +654,28 @@ bufid(int ch, register struct iobuf *ob)
 }
 
 usch idbuf[MAXIDSZ+1];
+unsigned int idhash;
 /*
  * readin chars and store in buf. Warn about too long names.
+ * The hash of the name is left in idhash.
  */
 usch *
 readid(int ch)
 {
 	register int p = 0;
+	register unsigned int h = IDHASH0;
 
 	do {
 		if (p == MAXIDSZ)
 			warning("identifier exceeds C99 5.2.4.1, truncating");
-		if (p < MAXIDSZ)
+		if (p < MAXIDSZ) {
 			idbuf[p++] = ch;
+			h = IDHASH(h, ch);
+		}
 	} while (ISID(ch = qcchar()));
 	idbuf[p] = 0;
 	unch(ch);
+	idhash = h;
 	return idbuf;
 }
 
@@ -847,7 +856,7 @@ run:			while ((ch = qcchar()) == '\t' || ch == ' ')
 				error("fastscan flslvl");
 
 			p = readid(ch);
-			if ((nl = lookup(p, FIND)) != NULL) {
+			if ((nl = hlookup(p, idhash, FIND)) != NULL) {
 				if ((ob = kfind(nl)) != NULL) {
 					if (*ob->buf == '-' || *ob->buf == '+')
 						putch(' ');
@@ -1016,6 +1025,32 @@ pb:	*--inp = c2;
 	return ch;
 }
 
+/*
+ * Files that need not be read again.  Those with #pragma once, and
+ * those wholly inside an include guard as long as its macro is defined.
+ * Files are identified by device and inode, so that different paths
+ * to the same file match.
+ */
+#define	INCSKIPSZ	64
+struct incskip {
+	struct incskip *next;
+	dev_t dev;
+	ino_t ino;
+	struct symtab *guard;	/* NULL if #pragma once */
+} *incskips[INCSKIPSZ];
+
+static struct incskip **
+incskipp(struct stat *st)
+{
+	struct incskip **isp;
+
+	isp = &incskips[(unsigned int)st->st_ino % INCSKIPSZ];
+	for (; *isp; isp = &(*isp)->next)
+		if ((*isp)->ino == st->st_ino && (*isp)->dev == st->st_dev)
+			break;
+	return isp;
+}
+
 /*
  * A new file included.
  * If ifiles == NULL, this is the first file and already opened (stdin).
@@ -1026,6 +1061,14 @@ pushfile(const usch *file, const usch *fn, int idx, void *incs)
 	struct includ ibuf;
 	register struct includ *ic;
 	register int otrulvl;
+	struct incskip *is, **isp;
+	struct stat st;
+
+	if (file == NULL || stat((const char *)file, &st) < 0)
+		st.st_ino = 0;
+	else if ((is = *incskipp(&st)) != NULL &&
+	    (is->guard == NULL || is->guard->valoff != 0))
+		return;
 
 	ic = &ibuf;
 	ic->next = ifiles;
@@ -1065,7 +1108,11 @@ pushfile(const usch *file, const usch *fn, int idx, void *incs)
 	ic->idx = idx;
 	ic->incs = incs;
 	ic->fn = fn;
+	ic->guard = NULL;
+	ic->gdepth = ic->once = 0;
 	prtline(1);
+	ic->gstate = GS_START;
+	gtrack = 1;
 	otrulvl = trulvl;
 
 	fastscan();
@@ -1073,7 +1120,18 @@ pushfile(const usch *file, const usch *fn, int idx, void *incs)
 	if (otrulvl != trulvl || flslvl)
 		error("unterminated conditional");
 
+	if (st.st_ino != 0 && (ic->once || ic->gstate == GS_END) &&
+	    *(isp = incskipp(&st)) == NULL) {
+		is = *isp = xmalloc(sizeof(struct incskip));
+		is->next = NULL;
+		is->dev = st.st_dev;
+		is->ino = st.st_ino;
+		is->guard = ic->once ? NULL : ic->guard;
+	}
+
 	ifiles = ic->next;
+	gtrack = ifiles &&
+	    (ifiles->gstate == GS_START || ifiles->gstate == GS_END);
 	inclevel--;
 #if LIBVMF
 	vmmodify(ic->vseg);
@@ -1251,6 +1309,8 @@ chknl(int ignore)
 static void
 elsestmt(void)
 {
+	if (ifiles->gstate == GS_IN && trulvl + flslvl == ifiles->gdepth)
+		NOGUARD();
 	if (flslvl) {
 		if (elflvl > trulvl)
 			;
@@ -1279,7 +1339,7 @@ ifdefstmt(void)
 		error("bad #ifdef");
 	bp = readid(ch);
 
-	if (lookup(bp, FIND) == NULL)
+	if (hlookup(bp, idhash, FIND) == NULL)
 		flslvl++;
 	else
 		trulvl++;
@@ -1295,10 +1355,16 @@ ifndefstmt(void)
 	if (!ISID0(ch = fastspc()))
 		error("bad #ifndef");
 	bp = readid(ch);
-	if (lookup(bp, FIND) != NULL)
+	if (hlookup(bp, idhash, FIND) != NULL)
 		flslvl++;
 	else
 		trulvl++;
+	if (gprev == GS_START) {
+		/* may be an include guard */
+		ifiles->guard = hlookup(bp, idhash, ENTER);
+		ifiles->gstate = GS_IN;
+		ifiles->gdepth = trulvl + flslvl;
+	}
 	chknl(0);
 }
 
@@ -1311,6 +1377,10 @@ endifstmt(void)
 		trulvl--;
 	else
 		error("#endif in non-conditional section");
+	if (ifiles->gstate == GS_IN && trulvl + flslvl < ifiles->gdepth) {
+		ifiles->gstate = GS_END;
+		gtrack = 1;
+	}
 	if (flslvl == 0)
 		elflvl = 0;
 	elslvl = 0;
@@ -1332,6 +1402,8 @@ elifstmt(void)
 {
 	register int oCflag = Cflag;
 
+	if (ifiles->gstate == GS_IN && trulvl + flslvl == ifiles->gdepth)
+		NOGUARD();
 	Cflag = 0;
 	if (flslvl == 0)
 		elflvl = trulvl;
@@ -1407,7 +1479,7 @@ undefstmt(void)
 	if (!ISID0(ch = fastspc()))
 		error("bad #undef");
 	bp = readid(ch);
-	if ((np = lookup(bp, FIND)) != NULL)
+	if ((np = hlookup(bp, idhash, FIND)) != NULL)
 		np->valoff = 0;
 	chknl(0);
 }
@@ -1428,12 +1500,30 @@ identstmt(void)
 static void
 pragmastmt(void)
 {
+	register struct iobuf *ob;
+	register usch *bp;
 	register int ch;
 
-	putstr((const usch *)"\n#pragma");
+	ob = getobuf(BNORMAL);
 	while ((ch = qcchar()) != '\n' && ch > 0)
-		putch(ch);
+		putob(ob, ch);
 	unch(ch);
+	putob(ob, 0);
+	for (bp = ob->buf; ISWS(*bp); bp++)
+		;
+	if (strncmp((char *)bp, "once", 4) == 0 && !ISID(bp[4])) {
+		for (bp += 4; ISWS(*bp); bp++)
+			;
+		if (*bp == 0) {
+			ifiles->once = 1;
+			bufree(ob);
+			prtline(1);
+			return;
+		}
+	}
+	putstr((const usch *)"\n#pragma");
+	putstr(ob->buf);
+	bufree(ob);
 	prtline(1);
 }
 
@@ -1555,6 +1645,9 @@ ppdir(void)
 	register int ch, i, oldC;
 	usch *bp;
 
+	/* only #ifndef may start an include guard */
+	if ((gprev = ifiles->gstate) != GS_IN)
+		NOGUARD();
 	oldC = Cflag;
 redo:	Cflag = 0;
 	if ((ch = fastspc()) == '\n') { /* empty directive */
@@ -44,7 +44,7 @@ int b2debug, c2debug, e2debug, f2debug, g2debug, o2debug;
 int r2debug, s2debug, t2debug, u2debug, x2debug;
 int gflag, kflag, pflag, sflag;
 int sspflag;
-int xscp, xssa, xtailcall, xtemps, xdeljumps, xdce, xinline, xccp, xgnu89, xgnu99;
+int xscp, xssa, xspace, xtailcall, xtemps, xdeljumps, xdce, xinline, xccp, xgnu89, xgnu99;
 int xuchar;
 int freestanding;
 char *prgname;
@@ -75,6 +75,8 @@ xopt(char *str)
 {
 	if (strcmp(str, "ssa") == 0)
 		xssa++;
+	else if (strcmp(str, "space") == 0)
+		xspace++;
 	else if (strcmp(str, "tailcall") == 0)
 		xtailcall++;
 	else if (strcmp(str, "temps") == 0)
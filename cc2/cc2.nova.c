@@ -98,10 +98,10 @@ main(int argc, char *argv[])
 	argc -= optind;
 	argv += optind;
 
-	if (argc > 0)
+	if (argc > 0 && strcmp(argv[0], "-") != 0)
 		if (freopen(argv[0], "r", stdin) == NULL)
 			err(1, "reopen stdin");
-	if (argc > 1)
+	if (argc > 1 && strcmp(argv[1], "-") != 0)
 		if (freopen(argv[1], "w", stdout) == NULL)
 			err(1, "reopen stdout");
 
@@ -0,0 +1,1070 @@
+/*	$Id$	*/
+
+/*
+ * Copyright (c) 2022 Alan Cox <etchedpixels@gmail.com>
+ * Copyright (c) 2021 Anders Magnusson. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ctype.h>
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "manifest.h"
+
+/*
+ * Peephole optimizer for TMS9995.
+ *
+ * Runs on the assembler text that ccom writes and cleans up the things
+ * the tree matcher cannot see because they span several instructions
+ * or statements. It is optional; the driver runs it at -O.
+ *
+ * The whole file is read into a list of lines. Each instruction is
+ * looked up in a table that tells which operands it reads and writes
+ * and which status bits it sets. Labels, directives, jumps and anything
+ * not in the table end a basic block and nothing is moved across them.
+ * A jump with a numeric displacement freezes the code up to the next
+ * label since its target depends on the instruction sizes.
+ *
+ * The rules are applied until nothing changes.
+ */
+
+#define	BUFLEN	256
+
+/* Status register bits (ST0-ST5) */
+#define	ST_LGT	001	/* logical greater than */
+#define	ST_AGT	002	/* arithmetic greater than */
+#define	ST_EQ	004	/* equal */
+#define	ST_C	010	/* carry */
+#define	ST_OV	020	/* overflow */
+#define	ST_OP	040	/* odd parity */
+#define	ST_CMP	(ST_LGT|ST_AGT|ST_EQ)
+#define	ST_ALL	077
+
+/* Instruction classes, decide how the operands are used */
+#define	I_MOV	1	/* src,dst: dst written */
+#define	I_ALU	2	/* src,dst: dst read and written */
+#define	I_CMP	3	/* src,dst: both only read */
+#define	I_REGOP	4	/* src,reg: reg read and written (xor) */
+#define	I_MPY	5	/* src,reg: reg read, reg and reg+1 written */
+#define	I_DIV	6	/* src,reg: reg and reg+1 read and written */
+#define	I_LI	7	/* reg,imm: reg written */
+#define	I_IMM	8	/* reg,imm: reg read and written */
+#define	I_CI	9	/* reg,imm: reg read */
+#define	I_ONE	10	/* dst: read and written */
+#define	I_CLR	11	/* dst: written */
+#define	I_SHIFT	12	/* reg,cnt: reg read and written, cnt 0 uses r0 */
+#define	I_IMPL	13	/* src: r0/r1 read and written (mpys/divs) */
+#define	I_JMP	14	/* conditional jump */
+#define	I_BR	15	/* b, unconditional */
+#define	I_CALL	16	/* bl */
+
+/* Flags */
+#define	I_BYTE	001	/* byte operation, status is for the byte */
+#define	I_CCDST	002	/* L> A> EQ are the word result compared to 0 */
+#define	I_CCSRC	004	/* L> A> EQ are the word source compared to 0 */
+
+struct insn {
+	char *name;
+	int class;
+	int flags;
+	int cc;		/* status bits set */
+	char *rev;	/* reversed condition for jumps */
+} insns[] = {
+	{ "mov",	I_MOV,	I_CCSRC|I_CCDST, ST_CMP },
+	{ "movb",	I_MOV,	I_BYTE,	ST_CMP|ST_OP },
+	{ "a",		I_ALU,	I_CCDST, ST_CMP|ST_C|ST_OV },
+	{ "ab",		I_ALU,	I_BYTE,	ST_ALL },
+	{ "s",		I_ALU,	I_CCDST, ST_CMP|ST_C|ST_OV },
+	{ "sb",		I_ALU,	I_BYTE,	ST_ALL },
+	{ "soc",	I_ALU,	I_CCDST, ST_CMP },
+	{ "socb",	I_ALU,	I_BYTE,	ST_CMP|ST_OP },
+	{ "szc",	I_ALU,	I_CCDST, ST_CMP },
+	{ "szcb",	I_ALU,	I_BYTE,	ST_CMP|ST_OP },
+	{ "c",		I_CMP,	0,	ST_CMP },
+	{ "cb",		I_CMP,	I_BYTE,	ST_CMP|ST_OP },
+	{ "coc",	I_CMP,	0,	ST_EQ },
+	{ "czc",	I_CMP,	0,	ST_EQ },
+	{ "xor",	I_REGOP, I_CCDST, ST_CMP },
+	{ "mpy",	I_MPY,	0,	0 },
+	{ "div",	I_DIV,	0,	ST_OV },
+	{ "li",		I_LI,	I_CCDST, ST_CMP },
+	{ "ai",		I_IMM,	I_CCDST, ST_CMP|ST_C|ST_OV },
+	{ "andi",	I_IMM,	I_CCDST, ST_CMP },
+	{ "ori",	I_IMM,	I_CCDST, ST_CMP },
+	{ "ci",		I_CI,	0,	ST_CMP },
+	{ "inc",	I_ONE,	I_CCDST, ST_CMP|ST_C|ST_OV },
+	{ "inct",	I_ONE,	I_CCDST, ST_CMP|ST_C|ST_OV },
+	{ "dec",	I_ONE,	I_CCDST, ST_CMP|ST_C|ST_OV },
+	{ "dect",	I_ONE,	I_CCDST, ST_CMP|ST_C|ST_OV },
+	{ "neg",	I_ONE,	I_CCDST, ST_CMP|ST_C|ST_OV },
+	{ "abs",	I_ONE,	0,	ST_CMP|ST_C|ST_OV },
+	{ "inv",	I_ONE,	I_CCDST, ST_CMP },
+	{ "swpb",	I_ONE,	0,	0 },
+	{ "clr",	I_CLR,	0,	0 },
+	{ "seto",	I_CLR,	0,	0 },
+	{ "sla",	I_SHIFT, I_CCDST, ST_CMP|ST_C|ST_OV },
+	{ "sra",	I_SHIFT, I_CCDST, ST_CMP|ST_C },
+	{ "srl",	I_SHIFT, I_CCDST, ST_CMP|ST_C },
+	{ "src",	I_SHIFT, I_CCDST, ST_CMP|ST_C },
+	{ "mpys",	I_IMPL,	0,	ST_CMP },
+	{ "divs",	I_IMPL,	0,	ST_CMP|ST_OV },
+	{ "jeq",	I_JMP,	0,	0, "ljne" },
+	{ "jne",	I_JMP,	0,	0, "ljeq" },
+	{ "jgt",	I_JMP },
+	{ "jlt",	I_JMP },
+	{ "jh",		I_JMP },
+	{ "jl",		I_JMP },
+	{ "jhe",	I_JMP },
+	{ "jle",	I_JMP },
+	{ "jnc",	I_JMP },
+	{ "joc",	I_JMP },
+	{ "jno",	I_JMP },
+	{ "jop",	I_JMP },
+	{ "ljeq",	I_JMP,	0,	0, "ljne" },
+	{ "ljne",	I_JMP,	0,	0, "ljeq" },
+	{ "ljlte",	I_JMP,	0,	0, "ljgt" },
+	{ "ljgt",	I_JMP,	0,	0, "ljlte" },
+	{ "ljlt",	I_JMP,	0,	0, "ljgte" },
+	{ "ljgte",	I_JMP,	0,	0, "ljlt" },
+	{ "ljle",	I_JMP,	0,	0, "ljh" },
+	{ "ljh",	I_JMP,	0,	0, "ljle" },
+	{ "ljl",	I_JMP,	0,	0, "ljhe" },
+	{ "ljhe",	I_JMP,	0,	0, "ljl" },
+	{ "jmp",	I_BR },
+	{ "b",		I_BR },
+	{ "bl",		I_CALL,	0,	ST_ALL },
+	{ NULL },
+};
+
+/* One line of assembler */
+struct line {
+	DLIST_ENTRY(line) link;
+	char *text;		/* line as read, or rewritten */
+	int type;
+#define	L_OTHER	0	/* comment or blank, ignored */
+#define	L_LABEL	1
+#define	L_DIR	2	/* directive */
+#define	L_INSN	3	/* known instruction */
+#define	L_UNK	4	/* instruction we know nothing about */
+	struct insn *ip;
+	int nop;		/* number of operands */
+	char *op[2];
+	int frozen;		/* inside a numeric jump, do not touch */
+};
+
+struct line lpole;
+
+/* Labels, to find where a jump goes and if anyone jumps there */
+struct sym {
+	struct sym *next;
+	char *name;
+	struct line *def;
+	int used;
+};
+#define	SYMHSZ	1024
+struct sym *symhash[SYMHSZ];
+
+int vflag;
+int nchg;
+int nstat[9];
+#define	S_DEADMOV	0
+#define	S_CMPZ		1
+#define	S_DEADCMP	2
+#define	S_SWPB		3
+#define	S_JNEXT		4
+#define	S_JOVER		5
+#define	S_STACK		6
+#define	S_MOVMOV	7
+#define	S_THREAD	8
+static char *statname[] = {
+	"dead register loads", "redundant compares with zero",
+	"dead compares", "swpb pairs", "jumps to next label",
+	"jumps over jumps", "stack adjusts", "move backs",
+	"jumps to jumps",
+};
+
+#define	VPRINT(...)	if (vflag) fprintf(stderr, __VA_ARGS__)
+
+static void readfile(void);
+static void labels(void);
+static void parse(struct line *);
+static void peep(void);
+static void printfile(void);
+
+int
+main(int argc, char *argv[])
+{
+	char *pname;
+	int ch, i;
+
+	pname = argv[0];
+	while ((ch = getopt(argc, argv, "v")) != -1) {
+		switch (ch) {
+		case 'v':
+			vflag++;
+			break;
+		default:
+			fprintf(stderr,
+			    "usage: %s [-v] [infile [outfile]]\n", pname);
+			exit(1);
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	if (argc > 0 && strcmp(argv[0], "-") != 0)
+		if (freopen(argv[0], "r", stdin) == NULL)
+			err(1, "reopen stdin");
+	if (argc > 1 && strcmp(argv[1], "-") != 0)
+		if (freopen(argv[1], "w", stdout) == NULL)
+			err(1, "reopen stdout");
+
+	DLIST_INIT(&lpole, link);
+	readfile();
+	labels();
+	peep();
+	printfile();
+
+	if (vflag)
+		for (i = 0; i < 9; i++)
+			fprintf(stderr, "%5d %s\n", nstat[i], statname[i]);
+	return 0;
+}
+
+/*
+ * Read in the whole file. Lines of any length are accepted as strings
+ * in .ascii directives may be long.
+ */
+static void
+readfile(void)
+{
+	struct line *l;
+	char buf[BUFLEN];
+	char *s;
+	size_t len, n;
+
+	for (;;) {
+		s = NULL;
+		len = 0;
+		while (fgets(buf, BUFLEN, stdin) != NULL) {
+			n = strlen(buf);
+			if ((s = realloc(s, len + n + 1)) == NULL)
+				err(1, "realloc");
+			memcpy(s + len, buf, n + 1);
+			len += n;
+			if (s[len-1] == '\n')
+				break;
+		}
+		if (s == NULL)
+			break;
+		if (len && s[len-1] == '\n')
+			s[--len] = 0;
+		if ((l = calloc(1, sizeof(struct line))) == NULL)
+			err(1, "calloc");
+		l->text = s;
+		parse(l);
+		DLIST_INSERT_BEFORE(&lpole, l, link);
+	}
+}
+
+static struct sym *
+symlook(char *s, size_t n)
+{
+	struct sym *sp;
+	unsigned int h = 0;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		h = h * 31 + (unsigned char)s[i];
+	h %= SYMHSZ;
+	for (sp = symhash[h]; sp; sp = sp->next)
+		if (strncmp(sp->name, s, n) == 0 && sp->name[n] == 0)
+			return sp;
+	if ((sp = calloc(1, sizeof(struct sym))) == NULL)
+		err(1, "calloc");
+	sp->name = strndup(s, n);
+	sp->next = symhash[h];
+	symhash[h] = sp;
+	return sp;
+}
+
+/*
+ * Find the definition of each label and mark those that something
+ * refers to. A local label nobody refers to does not end a block.
+ */
+static void
+labels(void)
+{
+	struct line *l;
+	char *s, *b;
+
+	DLIST_FOREACH(l, &lpole, link) {
+		if (l->type == L_LABEL) {
+			symlook(l->op[0], strlen(l->op[0]))->def = l;
+			continue;
+		}
+		for (s = l->text; *s && *s != ';'; ) {
+			if (*s == '"')
+				break;	/* strings hold no labels */
+			if (isalpha((unsigned char)*s) || *s == '_') {
+				for (b = s; isalnum((unsigned char)*s) ||
+				    *s == '_'; s++)
+					;
+				symlook(b, s - b)->used = 1;
+			} else
+				s++;
+		}
+	}
+	DLIST_FOREACH(l, &lpole, link)
+		if (l->type == L_LABEL && l->op[0][0] == 'L' &&
+		    !symlook(l->op[0], strlen(l->op[0]))->used)
+			l->type = L_OTHER;
+}
+
+static struct insn *
+findinsn(char *s)
+{
+	struct insn *ip;
+
+	for (ip = insns; ip->name; ip++)
+		if (strcmp(ip->name, s) == 0)
+			return ip;
+	return NULL;
+}
+
+/*
+ * Split a line into label, directive or instruction and operands.
+ * This expects the syntax that ccom writes, do not try to parse
+ * anything else.
+ */
+static void
+parse(struct line *l)
+{
+	char *s, *b, *e;
+	int i;
+
+	l->type = L_OTHER;
+	l->ip = NULL;
+	l->nop = 0;
+	s = l->text;
+	if (*s != ' ' && *s != '\t' && *s != ';' && *s != '.' && *s) {
+		for (b = s; isalnum((unsigned char)*b) || *b == '_'; b++)
+			;
+		if (*b == ':' && b != s) {
+			l->type = L_LABEL;
+			l->op[0] = strndup(s, b - s);
+			return;
+		}
+	}
+	while (*s == ' ' || *s == '\t')
+		s++;
+	if (*s == 0 || *s == ';')
+		return;
+	if (*s == '.') {
+		l->type = L_DIR;
+		return;
+	}
+
+	for (b = s; *b && !isspace((unsigned char)*b) && *b != ';'; b++)
+		;
+	l->op[0] = strndup(s, b - s);
+	for (i = 0; l->op[0][i]; i++)
+		l->op[0][i] = tolower((unsigned char)l->op[0][i]);
+	if ((l->ip = findinsn(l->op[0])) == NULL) {
+		l->type = L_UNK;
+		return;
+	}
+	free(l->op[0]);
+	l->type = L_INSN;
+
+	/* Operands up to the comment, at most two */
+	while (*b == ' ' || *b == '\t')
+		b++;
+	while (*b && *b != ';') {
+		while (*b == ' ' || *b == '\t')
+			b++;
+		for (e = b; *e && *e != ',' && *e != ';'; e++)
+			;
+		s = e;
+		while (s > b && isspace((unsigned char)s[-1]))
+			s--;
+		if (l->nop == 2) {
+			l->type = L_UNK;
+			return;
+		}
+		l->op[l->nop++] = strndup(b, s - b);
+		b = *e == ',' ? e + 1 : e;
+	}
+}
+
+/*
+ * Return the register number if s is a register (rN), otherwise -1.
+ */
+static int
+isreg(char *s)
+{
+	int r;
+
+	if (s[0] != 'r' && s[0] != 'R')
+		return -1;
+	if (!isdigit((unsigned char)s[1]))
+		return -1;
+	r = s[1] - '0';
+	if (isdigit((unsigned char)s[2])) {
+		r = r * 10 + s[2] - '0';
+		if (s[3])
+			return -1;
+	} else if (s[2])
+		return -1;
+	return r < 16 ? r : -1;
+}
+
+/*
+ * Registers used for the address of an operand, and registers modified
+ * by the addressing mode itself (*rN+).
+ */
+static int
+opregs(char *s, int *mod)
+{
+	char *b;
+	int r;
+
+	*mod = 0;
+	if (*s == '*') {
+		b = strndup(s + 1, strcspn(s + 1, "+"));
+		r = isreg(b);
+		free(b);
+		if (r < 0)
+			return 0;
+		if (s[strlen(s)-1] == '+')
+			*mod = 1 << r;
+		return 1 << r;
+	}
+	if (*s == '@' && (b = strchr(s, '(')) != NULL) {
+		b = strndup(b + 1, strcspn(b + 1, ")"));
+		r = isreg(b);
+		free(b);
+		return r < 0 ? 0 : 1 << r;
+	}
+	return 0;
+}
+
+/*
+ * Find out which registers an instruction reads and writes. Writes
+ * are only reported if the whole register is replaced; a partial write
+ * (movb into a register) counts as a read as well.
+ * Returns 0 if the instruction cannot be understood.
+ */
+static int
+regrw(struct line *l, int *rd, int *wr)
+{
+	struct insn *ip = l->ip;
+	int r0, r1, a0, a1, m0, m1;
+
+	*rd = *wr = 0;
+	if (l->type != L_INSN)
+		return 0;
+	r0 = r1 = -1;
+	a0 = a1 = m0 = m1 = 0;
+	if (l->nop > 0) {
+		r0 = isreg(l->op[0]);
+		a0 = opregs(l->op[0], &m0);
+	}
+	if (l->nop > 1) {
+		r1 = isreg(l->op[1]);
+		a1 = opregs(l->op[1], &m1);
+	}
+	*rd = a0 | a1;
+	*wr = m0 | m1;
+	*rd |= m0 | m1;
+
+	switch (ip->class) {
+	case I_MOV:
+	case I_ALU:
+	case I_CMP:
+		if (l->nop != 2)
+			return 0;
+		if (r0 >= 0)
+			*rd |= 1 << r0;
+		if (r1 >= 0) {
+			if (ip->class != I_MOV || (ip->flags & I_BYTE))
+				*rd |= 1 << r1;
+			if (ip->class != I_CMP)
+				*wr |= 1 << r1;
+		}
+		break;
+	case I_REGOP:
+	case I_MPY:
+	case I_DIV:
+		if (l->nop != 2 || r1 < 0 || r1 > 14)
+			return 0;
+		if (r0 >= 0)
+			*rd |= 1 << r0;
+		*rd |= 1 << r1;
+		*wr |= 1 << r1;
+		if (ip->class == I_DIV)
+			*rd |= 1 << (r1 + 1);
+		if (ip->class != I_REGOP)
+			*wr |= 1 << (r1 + 1);
+		break;
+	case I_LI:
+	case I_IMM:
+	case I_CI:
+		if (l->nop != 2 || r0 < 0)
+			return 0;
+		if (ip->class != I_LI)
+			*rd |= 1 << r0;
+		if (ip->class != I_CI)
+			*wr |= 1 << r0;
+		break;
+	case I_ONE:
+	case I_CLR:
+		if (l->nop != 1)
+			return 0;
+		if (r0 >= 0) {
+			if (ip->class == I_ONE)
+				*rd |= 1 << r0;
+			*wr |= 1 << r0;
+		}
+		break;
+	case I_SHIFT:
+		if (l->nop != 2 || r0 < 0)
+			return 0;
+		*rd |= 1 << r0;
+		*wr |= 1 << r0;
+		if (strcmp(l->op[1], "0") == 0 || isreg(l->op[1]) == 0)
+			*rd |= 1;
+		break;
+	case I_IMPL:
+		if (l->nop != 1)
+			return 0;
+		if (r0 >= 0)
+			*rd |= 1 << r0;
+		*rd |= 3;
+		*wr |= 3;
+		break;
+	case I_JMP:
+		break;
+	default:
+		/* branches and calls use everything */
+		*rd = 0xffff;
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * The label a jump or branch goes to, or NULL if it is computed or a
+ * numeric displacement.
+ */
+static char *
+jtarget(struct line *l)
+{
+	char *s;
+
+	if (l->type != L_INSN || l->nop != 1)
+		return NULL;
+	if (l->ip->class != I_JMP && l->ip->class != I_BR)
+		return NULL;
+	s = l->op[0];
+	if (*s == '@')
+		s++;
+	if (!isalpha((unsigned char)*s) && *s != '_')
+		return NULL;
+	if (strchr(s, '(') || strchr(s, '+') || isreg(s) >= 0)
+		return NULL;
+	return s;
+}
+
+/*
+ * A line that ends a basic block, we never look past those.
+ */
+static int
+isend(struct line *l)
+{
+	if (l->type == L_LABEL || l->type == L_DIR || l->type == L_UNK)
+		return 1;
+	if (l->type != L_INSN)
+		return 0;
+	return l->ip->class == I_JMP || l->ip->class == I_BR ||
+	    l->ip->class == I_CALL || l->frozen;
+}
+
+static struct line *
+next(struct line *l)
+{
+	do
+		l = DLIST_NEXT(l, link);
+	while (l != &lpole && l->type == L_OTHER);
+	return l;
+}
+
+static struct line *
+prev(struct line *l)
+{
+	do
+		l = DLIST_PREV(l, link);
+	while (l != &lpole && l->type == L_OTHER);
+	return l;
+}
+
+static void
+delline(struct line *l)
+{
+	VPRINT("delete: %s\n", l->text);
+	DLIST_REMOVE(l, link);
+	nchg++;
+}
+
+/* Replace an instruction, keep it parsed */
+static void
+newinsn(struct line *l, char *name, char *op0, char *op1)
+{
+	char *s;
+	size_t n;
+
+	n = strlen(name) + strlen(op0) + (op1 ? strlen(op1) : 0) + 4;
+	if ((s = malloc(n)) == NULL)
+		err(1, "malloc");
+	snprintf(s, n, "%s\t%s%s%s", name, op0, op1 ? "," : "", op1 ? op1 : "");
+	VPRINT("replace: %s -> %s\n", l->text, s);
+	l->text = s;
+	parse(l);
+	nchg++;
+}
+
+/*
+ * Is register r dead after l? Dead means it is written before it is
+ * read on the way to the end of the block. A conditional jump or any
+ * block end keeps it alive since the code we jump to may need it.
+ */
+static int
+regdead(struct line *l, int r)
+{
+	int rd, wr;
+
+	for (l = next(l); l != &lpole; l = next(l)) {
+		if (l->type != L_INSN)
+			return 0;
+		if (!regrw(l, &rd, &wr) || (rd & (1 << r)))
+			return 0;
+		if (wr & (1 << r))
+			return 1;
+		if (isend(l))
+			return 0;
+	}
+	return 0;
+}
+
+/*
+ * Are the status bits in st dead after l? They are dead if they are
+ * all set again before anything could test them. Calls and returns do
+ * not look at the status; other block ends may.
+ */
+static int
+ccdead(struct line *l, int st)
+{
+	for (l = next(l); l != &lpole; l = next(l)) {
+		if (l->type != L_INSN)
+			return 0;
+		if (l->ip->class == I_CALL)
+			return 1;
+		if (isend(l))
+			return 0;
+		st &= ~l->ip->cc;
+		if (st == 0)
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * Delete loads of registers that are never used; this catches the
+ * mov r11,r0 that is left when nothing needed the return address in r0.
+ * Only register and immediate sources, memory may be volatile.
+ */
+static int
+deadmov(struct line *l)
+{
+	struct insn *ip = l->ip;
+	int r;
+
+	if (ip->class == I_MOV && !(ip->flags & I_BYTE)) {
+		if (isreg(l->op[0]) < 0)
+			return 0;
+		r = isreg(l->op[1]);
+	} else if (ip->class == I_LI || ip->class == I_CLR)
+		r = isreg(l->op[0]);
+	else
+		return 0;
+	if (r < 0 || r > 10)
+		return 0;	/* leave the fixed registers alone */
+	if (!regdead(l, r))
+		return 0;
+	if (ip->cc && !ccdead(l, ip->cc))
+		return 0;
+	nstat[S_DEADMOV]++;
+	delline(l);
+	return 1;
+}
+
+/*
+ * The register whose word value the status was set from, or -1.
+ */
+static int
+ccsubj(struct line *l)
+{
+	struct insn *ip = l->ip;
+
+	if ((ip->flags & I_CCSRC) && isreg(l->op[0]) >= 0)
+		return isreg(l->op[0]);
+	if (!(ip->flags & I_CCDST))
+		return -1;
+	switch (ip->class) {
+	case I_MOV:
+	case I_ALU:
+	case I_REGOP:
+		return isreg(l->op[1]);
+	default:
+		return isreg(l->op[0]);
+	}
+}
+
+/*
+ * ci rN,0 (or mov rN,rN) after an instruction that already left the
+ * status for the word in rN compared with zero. C and OV are not
+ * touched by ci so they are the same either way.
+ */
+static int
+cmpzero(struct line *l)
+{
+	struct line *p;
+	int r, rd, wr;
+
+	if (l->ip->class == I_CI) {
+		if (strcmp(l->op[1], "0") != 0)
+			return 0;
+		r = isreg(l->op[0]);
+	} else if (strcmp(l->ip->name, "mov") == 0 &&
+	    strcmp(l->op[0], l->op[1]) == 0)
+		r = isreg(l->op[0]);
+	else
+		return 0;
+	if (r < 0)
+		return 0;
+
+	for (p = prev(l); p != &lpole; p = prev(p)) {
+		if (p->type != L_INSN || p->frozen)
+			return 0;
+		if (p->ip->class == I_CALL || p->ip->class == I_BR)
+			return 0;
+		if (!regrw(p, &rd, &wr) && p->ip->class != I_JMP)
+			return 0;
+		if (p->ip->cc & ST_CMP) {
+			if (ccsubj(p) == r || (strcmp(p->ip->name, "mov") == 0 &&
+			    isreg(p->op[1]) == r))
+				break;
+			return 0;
+		}
+		if (wr & (1 << r))
+			return 0;
+	}
+	if (p == &lpole)
+		return 0;
+	nstat[S_CMPZ]++;
+	delline(l);
+	return 1;
+}
+
+/*
+ * A compare whose result is never looked at.
+ */
+static int
+deadcmp(struct line *l)
+{
+	if (l->ip->class != I_CMP && l->ip->class != I_CI)
+		return 0;
+	/* memory may be volatile */
+	if (isreg(l->op[0]) < 0 ||
+	    (l->ip->class == I_CMP && isreg(l->op[1]) < 0))
+		return 0;
+	if (!ccdead(l, l->ip->cc))
+		return 0;
+	nstat[S_DEADCMP]++;
+	delline(l);
+	return 1;
+}
+
+/*
+ * Two swpb of the same register with nothing using it inbetween.
+ * swpb does not change the status.
+ */
+static int
+swpbpair(struct line *l)
+{
+	struct line *n;
+	int r, rd, wr;
+
+	if (strcmp(l->ip->name, "swpb") != 0 || (r = isreg(l->op[0])) < 0)
+		return 0;
+	for (n = next(l); n != &lpole; n = next(n)) {
+		if (n->type != L_INSN || n->frozen)
+			return 0;
+		if (strcmp(n->ip->name, "swpb") == 0 &&
+		    strcmp(n->op[0], l->op[0]) == 0)
+			break;
+		if (!regrw(n, &rd, &wr) || ((rd | wr) & (1 << r)))
+			return 0;
+		if (isend(n))
+			return 0;
+	}
+	if (n == &lpole)
+		return 0;
+	nstat[S_SWPB]++;
+	delline(n);
+	delline(l);
+	return 1;
+}
+
+/*
+ * Is label s among the labels directly after l?
+ */
+static int
+labelnext(struct line *l, char *s)
+{
+	for (l = next(l); l != &lpole && l->type == L_LABEL; l = next(l))
+		if (strcmp(l->op[0], s) == 0)
+			return 1;
+	return 0;
+}
+
+/*
+ * Jumps to the next label, and conditional jumps over an unconditional
+ * one that can be turned around.
+ */
+static int
+jumps(struct line *l)
+{
+	struct line *n;
+	char *s, *t, *rev;
+
+	if ((s = jtarget(l)) == NULL)
+		return 0;
+	if (labelnext(l, s)) {
+		nstat[S_JNEXT]++;
+		delline(l);
+		return 1;
+	}
+	if (l->ip->class != I_JMP || l->ip->rev == NULL)
+		return 0;
+	n = next(l);
+	if (n == &lpole || n->type != L_INSN || n->ip->class != I_BR ||
+	    (t = jtarget(n)) == NULL || !labelnext(n, s))
+		return 0;
+	nstat[S_JOVER]++;
+	rev = l->ip->rev;
+	newinsn(l, rev, n->op[0], NULL);
+	delline(n);
+	return 1;
+}
+
+/*
+ * The amount a constant stack adjust (inct, dect or ai r13) moves r13,
+ * or 0 if l is something else.
+ */
+static int
+stackoff(struct line *l)
+{
+	char *e;
+	long v;
+
+	if (l == &lpole || l->type != L_INSN || l->frozen ||
+	    isreg(l->op[0]) != 13)
+		return 0;
+	if (strcmp(l->ip->name, "inct") == 0)
+		return 2;
+	if (strcmp(l->ip->name, "dect") == 0)
+		return -2;
+	if (strcmp(l->ip->name, "ai") != 0)
+		return 0;
+	v = strtol(l->op[1], &e, 10);
+	return *e || v < -32768 || v > 32767 ? 0 : (int)v;
+}
+
+/*
+ * A stack adjust followed by dect r13, which is what you get from
+ * popping the arguments of one call and pushing the first one of the
+ * next. They are folded into one adjust, or none if they cancel.
+ *
+ * Runs of pushes (dect r13, mov x,*r13) are not merged into one ai and
+ * indexed moves: ai and the index words make that one word longer and
+ * slower than the dect instructions it replaces.
+ */
+static int
+stackadj(struct line *l)
+{
+	struct line *n;
+	char buf[16];
+	int o;
+
+	if ((o = stackoff(l)) <= 0)
+		return 0;
+	n = next(l);
+	if (stackoff(n) != -2 || !ccdead(n, n->ip->cc))
+		return 0;
+	nstat[S_STACK]++;
+	delline(n);
+	if ((o -= 2) == 0)
+		delline(l);
+	else if (o == 2)
+		newinsn(l, "inct", "r13", NULL);
+	else {
+		snprintf(buf, sizeof(buf), "%d", o);
+		newinsn(l, "ai", "r13", buf);
+	}
+	return 1;
+}
+
+/*
+ * mov rA,rB followed by mov rB,rA. The second one sets the same status.
+ */
+static int
+movmov(struct line *l)
+{
+	struct line *n;
+
+	if (strcmp(l->ip->name, "mov") != 0 || isreg(l->op[0]) < 0 ||
+	    isreg(l->op[1]) < 0)
+		return 0;
+	n = next(l);
+	if (n == &lpole || n->type != L_INSN || n->frozen ||
+	    strcmp(n->ip->name, "mov") != 0 ||
+	    strcmp(n->op[0], l->op[1]) != 0 || strcmp(n->op[1], l->op[0]) != 0)
+		return 0;
+	nstat[S_MOVMOV]++;
+	delline(n);
+	return 1;
+}
+
+/*
+ * A jump to an unconditional branch goes straight to where that one
+ * goes. Short jumps are left alone as the new target may be far away.
+ */
+static int
+thread(struct line *l)
+{
+	struct line *n;
+	struct sym *sp;
+	char *s, *t, *u, *buf;
+	int i;
+
+	if (strcmp(l->ip->name, "b") != 0 && strncmp(l->ip->name, "lj", 2) != 0)
+		return 0;
+	if ((s = jtarget(l)) == NULL)
+		return 0;
+	for (i = 0, t = s; i < 10; i++, t = u) {
+		sp = symlook(t, strlen(t));
+		if ((n = sp->def) == NULL)
+			break;
+		while ((n = next(n)) != &lpole && n->type == L_LABEL)
+			;
+		if (n == &lpole || n->type != L_INSN || n->frozen ||
+		    strcmp(n->ip->name, "b") != 0 || (u = jtarget(n)) == NULL)
+			break;
+	}
+	if (i == 10 || strcmp(s, t) == 0)
+		return 0;	/* nothing to do, or a loop */
+	nstat[S_THREAD]++;
+	if ((buf = malloc(strlen(t) + 2)) == NULL)
+		err(1, "malloc");
+	sprintf(buf, "@%s", t);
+	newinsn(l, l->ip->name, buf, NULL);
+	free(buf);
+	return 1;
+}
+
+/*
+ * Rules, tried in order on each instruction.
+ */
+static int (*rules[])(struct line *) = {
+	jumps, thread, swpbpair, stackadj, movmov, cmpzero, deadcmp, deadmov,
+	NULL
+};
+
+/*
+ * Mark the code that a numeric jump skips over.
+ */
+static void
+freeze(void)
+{
+	struct line *l;
+	int f = 0;
+
+	DLIST_FOREACH(l, &lpole, link) {
+		if (l->type == L_LABEL)
+			f = 0;
+		if (l->type == L_INSN && l->nop == 1 &&
+		    (l->ip->class == I_JMP || l->ip->class == I_BR) &&
+		    (isdigit((unsigned char)l->op[0][0]) || l->op[0][0] == '$' ||
+		    l->op[0][0] == '-'))
+			f = 1;
+		l->frozen = f;
+	}
+}
+
+static void
+peep(void)
+{
+	struct line *l, *p;
+	int i;
+
+	freeze();
+	do {
+		nchg = 0;
+		for (l = DLIST_NEXT(&lpole, link); l != &lpole;
+		    l = DLIST_NEXT(l, link)) {
+			if (l->type != L_INSN || l->frozen)
+				continue;
+			/* rules only remove l and what follows it */
+			p = DLIST_PREV(l, link);
+			for (i = 0; rules[i]; i++) {
+				if ((*rules[i])(l)) {
+					l = p;
+					break;
+				}
+			}
+		}
+	} while (nchg);
+}
+
+static void
+printfile(void)
+{
+	struct line *l;
+
+	DLIST_FOREACH(l, &lpole, link)
+		printf("%s\n", l->text);
+}
@@ -331,11 +331,27 @@ warner(int type, ...)
 static NODE *freelink;
 int usednodes;
 
+/*
+ * Nodes are handed out from an arena of chunks in allocation order,
+ * so that a tree built at once also lies together in memory.
+ * When all nodes are free again nodereset() drops the freelist and
+ * all chunks but one, so memory does not grow with the input size.
+ */
+#define	NODECHUNK	256	/* nodes per chunk */
+struct nodechunk {
+	struct nodechunk *next;
+	NODE n[NODECHUNK];
+};
+static struct nodechunk *nodechunks;
+static int nodeleft, nodenchunks;
+int noderesets;
+
 #ifndef LANG_F77
 NODE *
 talloc(void)
 {
 	register NODE *p;
+	struct nodechunk *nc;
 
 	usednodes++;
 
@@ -349,13 +365,42 @@ talloc(void)
 		return p;
 	}
 
-	p = permalloc(sizeof(NODE));
-	nodesszcnt += sizeof(NODE);
+	if (nodeleft == 0) {
+		if ((nc = malloc(sizeof(struct nodechunk))) == NULL)
+			cerror("talloc: out of memory");
+		nc->next = nodechunks;
+		nodechunks = nc;
+		nodeleft = NODECHUNK;
+		if (++nodenchunks * (int)sizeof(struct nodechunk) > nodesszcnt)
+			nodesszcnt = nodenchunks * sizeof(struct nodechunk);
+	}
+	p = &nodechunks->n[NODECHUNK - nodeleft--];
 	p->n_op = FREE;
 	if (ndebug)
 		printf("alloc node %p from memory\n", p);
 	return p;
 }
+
+/*
+ * Release the node arena if no node is in use.  Called when a
+ * function is finished.
+ */
+void
+nodereset(void)
+{
+	struct nodechunk *nc;
+
+	if (usednodes != 0 || nodechunks == NULL)
+		return;
+	while ((nc = nodechunks->next) != NULL) {
+		nodechunks->next = nc->next;
+		free(nc);
+	}
+	nodenchunks = 1;
+	nodeleft = NODECHUNK;
+	freelink = NULL;
+	noderesets++;
+}
 #endif
 
 /*
@@ -582,6 +627,95 @@ mkdope(void)
 	}
 }
 
+/*
+ * does the type t match tword
+ */
+int
+ttype(TWORD t, int tword)
+{
+	if (tword & TANY)
+		return(1);
+
+#if defined(PCC_DEBUG) && !defined(MKEXT)
+	if (t2debug)
+		printf("ttype(0x%x, 0x%x)\n", t, tword);
+#endif
+	if (ISPTR(t) && ISFTN(DECREF(t)) && (tword & TFTN)) {
+		/* For funny function pointers */
+		return 1;
+	}
+	if (ISPTR(t) && (tword&TPTRTO)) {
+		do {
+			t = DECREF(t);
+		} while (ISARY(t));
+			/* arrays that are left are usually only
+			 * in structure references...
+			 */
+		return (ttype(t, tword&(~TPTRTO)));
+	}
+	if (t != BTYPE(t))
+		return (tword & TPOINT); /* TPOINT means not simple! */
+	if (tword & TPTRTO)
+		return(0);
+
+	switch (t) {
+	case CHAR:
+		return( tword & TCHAR );
+	case SHORT:
+		return( tword & TSHORT );
+	case STRTY:
+	case UNIONTY:
+		return( tword & TSTRUCT );
+	case INT:
+		return( tword & TINT );
+	case UNSIGNED:
+		return( tword & TUNSIGNED );
+	case USHORT:
+		return( tword & TUSHORT );
+	case UCHAR:
+		return( tword & TUCHAR );
+	case ULONG:
+		return( tword & TULONG );
+	case LONG:
+		return( tword & TLONG );
+	case LONGLONG:
+		return( tword & TLONGLONG );
+	case ULONGLONG:
+		return( tword & TULONGLONG );
+	case FLOAT:
+		return( tword & TFLOAT );
+	case DOUBLE:
+		return( tword & TDOUBLE );
+	case LDOUBLE:
+		return( tword & TLDOUBLE );
+	}
+
+	return(0);
+}
+
+/*
+ * Return the type class of t, see pass2.h.
+ */
+int
+tclass(TWORD t)
+{
+	int c = 0;
+
+	if (ISPTR(t) && ISFTN(DECREF(t)))
+		return TC_PFTN;
+	if (ISPTR(t)) {
+		do {
+			t = DECREF(t);
+		} while (ISARY(t));
+		c = TC_PTR;
+		if (ISPTR(t) && ISFTN(DECREF(t)))
+			return c + TC_PFTN;
+	}
+	if (t != BTYPE(t))
+		return c + TC_POINT;
+	return c + t;
+}
+
 /*
  * output a nice description of the type of t
  */
@@ -174,8 +174,8 @@
  */
 extern int gflag, kflag, pflag;
 extern int sspflag;
-extern int xscp, xssa, xtailcall, xtemps, xdeljumps, xdce;
-extern int xuchar;
+extern int xscp, xssa, xspace, xtailcall, xtemps, xdeljumps, xdce, xcse, xloop;
+extern int xuchar, xtextir;
 
 int yyparse(void);
 void yyaccpt(void);
@@ -301,6 +301,24 @@ struct interpass_prolog;
 #define	IP_ASM		7
 #define	MAXIP		7
 
+/*
+ * Binary intermediate code from pass1 to pass2 in two-pass mode.
+ * The file starts with IR_MAGIC followed by the version as a varint.
+ * Records start with a tag byte with the high bit set; lines starting
+ * with anything else are read as the text format (see pass2_compile()).
+ * Numbers are varints, seven bits per byte low bits first, signed
+ * numbers zigzag encoded.  Names are indices into a string table,
+ * 0 means a new string follows as length and bytes.
+ */
+#define	IR_MAGIC	"\177pcc"
+#define	IR_VERSION	1
+#define	IR_NODE		0200	/* node count, nodes in prefix order */
+#define	IR_PROLOG	0201
+#define	IR_EPILOG	0202
+#define	IR_DEFLAB	0203
+#define	IR_ASM		0204
+#define	IR_LINE		0205
+
 void send_passt(int type, ...);
 
 
@@ -377,6 +395,7 @@ void werror(const char *s, ...);
 void uerror(const char *s, ...);
 void mkdope(void);
 void tcheck(void);
+void nodereset(void);
 
 extern	int nerrors;		/* number of errors seen so far */
 extern	int warniserr;		/* treat warnings as errors */
@@ -186,69 +186,41 @@ tshape(NODE *p, int shape)
 }
 
 /*
- * does the type t match tword
+ * Small memo of tshape() results.  The find*() routines test the same
+ * few nodes against the same shapes for many table entries, and the
+ * shape routines may be expensive (special() e.g. searches multiply
+ * chains).  Nothing is rewritten while a single find*() runs, so the
+ * answers are kept until shnew() is called at the start of the next.
  */
-int
-ttype(TWORD t, int tword)
+#define NSHMEMO	32
+static struct shmemo {
+	NODE *p;
+	int shape, sh, gen;
+} shmemo[NSHMEMO];
+static int shgen;
+
+static void
+shnew(void)
 {
-	if (tword & TANY)
-		return(1);
-
-#ifdef PCC_DEBUG
-	if (t2debug)
-		printf("ttype(0x%x, 0x%x)\n", t, tword);
-#endif
-	if (ISPTR(t) && ISFTN(DECREF(t)) && (tword & TFTN)) {
-		/* For funny function pointers */
-		return 1;
-	}
-	if (ISPTR(t) && (tword&TPTRTO)) {
-		do {
-			t = DECREF(t);
-		} while (ISARY(t));
-			/* arrays that are left are usually only
-			 * in structure references...
-			 */
-		return (ttype(t, tword&(~TPTRTO)));
-	}
-	if (t != BTYPE(t))
-		return (tword & TPOINT); /* TPOINT means not simple! */
-	if (tword & TPTRTO)
-		return(0);
-
-	switch (t) {
-	case CHAR:
-		return( tword & TCHAR );
-	case SHORT:
-		return( tword & TSHORT );
-	case STRTY:
-	case UNIONTY:
-		return( tword & TSTRUCT );
-	case INT:
-		return( tword & TINT );
-	case UNSIGNED:
-		return( tword & TUNSIGNED );
-	case USHORT:
-		return( tword & TUSHORT );
-	case UCHAR:
-		return( tword & TUCHAR );
-	case ULONG:
-		return( tword & TULONG );
-	case LONG:
-		return( tword & TLONG );
-	case LONGLONG:
-		return( tword & TLONGLONG );
-	case ULONGLONG:
-		return( tword & TULONGLONG );
-	case FLOAT:
-		return( tword & TFLOAT );
-	case DOUBLE:
-		return( tword & TDOUBLE );
-	case LDOUBLE:
-		return( tword & TLDOUBLE );
+	if (++shgen == 0) {
+		memset(shmemo, 0, sizeof(shmemo));
+		shgen = 1;
 	}
+}
 
-	return(0);
+static int
+tshapem(NODE *p, int shape)
+{
+	struct shmemo *m;
+
+	m = &shmemo[(((size_t)p >> 4) ^ shape) & (NSHMEMO-1)];
+	if (m->gen != shgen || m->p != p || m->shape != shape) {
+		m->p = p;
+		m->shape = shape;
+		m->sh = tshape(p, shape);
+		m->gen = shgen;
+	}
+	return m->sh;
 }
 
 #define FLDSZ(x)	UPKFSZ(x)
@@ -459,7 +431,7 @@ chcheck(NODE *p, int shape, int rew)
 	if (shape & SPECIAL)
 		shape = 0;
 
-	switch ((sh = tshape(p, sha))) {
+	switch ((sh = tshapem(p, sha))) {
 	case SRNOPE:
 		if (shape & INREGS)
 			sh = SRREG;
@@ -550,11 +522,12 @@ hasneed2(char *w, int need, int need2)
  * Whether 2-op instructions or 3-op is preferred is depending on in
  * which order they are found in the table.
  * mtchno is set to the count of regs needed for its legs.
+ * The table entries are looked up through QINDEX(), so the types of
+ * the legs already match (made by mkext).
  */
 int
 findops(NODE *p, int cookie)
 {
-	extern int *qtable[];
 	struct optab *q, *qq = NULL;
 	int i, shl, shr, *ixp, sh;
 	int lvl = 10, idx = 0, gol = 0, gor = 0;
@@ -563,9 +536,10 @@ findops(NODE *p, int cookie)
 	F2DEBUG(("findops node %p (%s)\n", p, prcook(cookie)));
 	F2WALK(p);
 
-	ixp = qtable[p->n_op];
 	l = getlr(p, 'L');
 	r = getlr(p, 'R');
+	shnew();
+	ixp = QINDEX(p->n_op, TYCLASS(l->n_type), TYCLASS(r->n_type));
 	for (i = 0; ixp[i] >= 0; i++) {
 		q = &table[ixp[i]];
 
@@ -573,10 +547,6 @@ findops(NODE *p, int cookie)
 		if (!acceptable(q))		/* target-dependent filter */
 			continue;
 
-		if (ttype(l->n_type, q->ltype) == 0 ||
-		    ttype(r->n_type, q->rtype) == 0)
-			continue; /* Types must be correct */
-
 		if ((cookie & q->visit) == 0)
 			continue; /* must get a result */
 
@@ -668,7 +638,6 @@ findops(NODE *p, int cookie)
 int
 relops(NODE *p)
 {
-	extern int *qtable[];
 	struct optab *q;
 	int i, shl = 0, shr = 0, sh;
 	NODE *l, *r;
@@ -680,7 +649,8 @@ relops(NODE *p)
 
 	l = getlr(p, 'L');
 	r = getlr(p, 'R');
-	ixp = qtable[p->n_op];
+	shnew();
+	ixp = QINDEX(p->n_op, TYCLASS(l->n_type), TYCLASS(r->n_type));
 	for (i = 0; ixp[i] >= 0; i++) {
 		q = &table[ixp[i]];
 
@@ -688,10 +658,6 @@ relops(NODE *p)
 		if (!acceptable(q))		/* target-dependent filter */
 			continue;
 
-		if (ttype(l->n_type, q->ltype) == 0 ||
-		    ttype(r->n_type, q->rtype) == 0)
-			continue; /* Types must be correct */
-
 		F2DEBUG(("relops got types\n"));
 		if ((shl = chcheck(l, q->lshape, 0)) == SRNOPE)
 			continue;
@@ -760,7 +726,6 @@ relops(NODE *p)
 int
 findasg(NODE *p, int cookie)
 {
-	extern int *qtable[];
 	struct optab *q;
 	int i, sh, shl, shr, lvl = 10;
 	NODE *l, *r;
@@ -773,9 +738,10 @@ findasg(NODE *p, int cookie)
 	F2DEBUG(("findasg tree: %s\n", prcook(cookie)));
 	F2WALK(p);
 
-	ixp = qtable[p->n_op];
 	l = getlr(p, 'L');
 	r = getlr(p, 'R');
+	shnew();
+	ixp = QINDEX(p->n_op, TYCLASS(l->n_type), TYCLASS(r->n_type));
 	for (i = 0; ixp[i] >= 0; i++) {
 		q = &table[ixp[i]];
 
@@ -783,10 +749,6 @@ findasg(NODE *p, int cookie)
 		if (!acceptable(q))		/* target-dependent filter */
 			continue;
 
-		if (ttype(l->n_type, q->ltype) == 0 ||
-		    ttype(r->n_type, q->rtype) == 0)
-			continue; /* Types must be correct */
-
 		if ((cookie & q->visit) == 0)
 			continue; /* must get a result */
 
@@ -801,7 +763,7 @@ findasg(NODE *p, int cookie)
 		} else
 #endif
 		{
-			if ((shl = tshape(l, q->lshape)) == SRNOPE)
+			if ((shl = tshapem(l, q->lshape)) == SRNOPE)
 				continue;
 			if (shl == SRREG)
 				continue;
@@ -889,7 +851,6 @@ findasg(NODE *p, int cookie)
 int
 findumul(NODE *p, int cookie)
 {
-	extern int *qtable[];
 	struct optab *q = NULL; /* XXX gcc */
 	int i, shl = 0, shr = 0, sh;
 	int *ixp;
@@ -897,7 +858,8 @@ findumul(NODE *p, int cookie)
 	F2DEBUG(("findumul p %p (%s)\n", p, prcook(cookie)));
 	F2WALK(p);
 
-	ixp = qtable[p->n_op];
+	shnew();
+	ixp = QINDEX(p->n_op, tcmap[TC_ANY], TYCLASS(p->n_type));
 	for (i = 0; ixp[i] >= 0; i++) {
 		q = &table[ixp[i]];
 
@@ -908,10 +870,6 @@ findumul(NODE *p, int cookie)
 		if ((q->visit & cookie) == 0)
 			continue; /* wrong registers */
 
-		if (ttype(p->n_type, q->rtype) == 0)
-			continue; /* Types must be correct */
-		
-
 		F2DEBUG(("findumul got types, rshape %s\n", prcook(q->rshape)));
 		/*
 		 * Try to create an OREG of the node.
@@ -960,7 +918,6 @@ findumul(NODE *p, int cookie)
 int
 findleaf(NODE *p, int cookie)
 {
-	extern int *qtable[];
 	struct optab *q = NULL; /* XXX gcc */
 	int i, sh;
 	int *ixp;
@@ -968,7 +925,9 @@ findleaf(NODE *p, int cookie)
 	F2DEBUG(("findleaf p %p (%s)\n", p, prcook(cookie)));
 	F2WALK(p);
 
-	ixp = qtable[p->n_op];
+	i = TYCLASS(p->n_type);
+	shnew();
+	ixp = QINDEX(p->n_op, i, i);
 	for (i = 0; ixp[i] >= 0; i++) {
 		q = &table[ixp[i]];
 
@@ -978,10 +937,6 @@ findleaf(NODE *p, int cookie)
 		if ((q->visit & cookie) == 0)
 			continue; /* wrong registers */
 
-		if (ttype(p->n_type, q->rtype) == 0 ||
-		    ttype(p->n_type, q->ltype) == 0)
-			continue; /* Types must be correct */
-
 		F2DEBUG(("findleaf got types, rshape %s\n", prcook(q->rshape)));
 
 		if (chcheck(p, q->rshape, 0) != SRDIR)
@@ -1021,7 +976,6 @@ findleaf(NODE *p, int cookie)
 int
 finduni(NODE *p, int cookie)
 {
-	extern int *qtable[];
 	struct optab *q;
 	NODE *l, *r;
 	int i, shl = 0, num = 4;
@@ -1036,7 +990,8 @@ finduni(NODE *p, int cookie)
 		r = p;
 	else
 		r = getlr(p, 'R');
-	ixp = qtable[p->n_op];
+	shnew();
+	ixp = QINDEX(p->n_op, TYCLASS(l->n_type), TYCLASS(r->n_type));
 	for (i = 0; ixp[i] >= 0; i++) {
 		q = &table[ixp[i]];
 
@@ -1044,13 +999,6 @@ finduni(NODE *p, int cookie)
 		if (!acceptable(q))		/* target-dependent filter */
 			continue;
 
-		if (ttype(l->n_type, q->ltype) == 0)
-			continue; /* Type must be correct */
-
-		F2DEBUG(("finduni got left type\n"));
-		if (ttype(r->n_type, q->rtype) == 0)
-			continue; /* Type must be correct */
-
 		F2DEBUG(("finduni got types\n"));
 		if ((shl = chcheck(l, q->lshape, q->rewrite & RLEFT)) == SRNOPE)
 			continue;
@@ -1126,9 +1074,8 @@ finduni(NODE *p, int cookie)
 int
 findmops(NODE *p, int cookie)
 {
-	extern int *qtable[];
 	struct optab *q;
-	int i, sh, shl, shr, lvl = 10;
+	int i, o, sh, shl, shr, lvl = 10;
 	NODE *l, *r;
 	int *ixp;
 	struct optab *qq = NULL; /* XXX gcc */
@@ -1149,9 +1096,11 @@ findmops(NODE *p, int cookie)
 	F2DEBUG(("findmops is useable\n"));
 
 	/* We can try to find a match.  Use right op */
-	ixp = qtable[r->n_op];
+	o = r->n_op;
 	l = getlr(r, 'L');
 	r = getlr(r, 'R');
+	shnew();
+	ixp = QINDEX(o, TYCLASS(l->n_type), TYCLASS(r->n_type));
 
 	for (i = 0; ixp[i] >= 0; i++) {
 		q = &table[ixp[i]];
@@ -1160,10 +1109,6 @@ findmops(NODE *p, int cookie)
 		if (!acceptable(q))		/* target-dependent filter */
 			continue;
 
-		if (ttype(l->n_type, q->ltype) == 0 ||
-		    ttype(r->n_type, q->rtype) == 0)
-			continue; /* Types must be correct */
-
 		F2DEBUG(("findmops got types\n"));
 
 		switch (cookie) {
@@ -1187,7 +1132,7 @@ findmops(NODE *p, int cookie)
 		/*
 		 * left shape must match left node.
 		 */
-		if ((shl = tshape(l, q->lshape)) != SRDIR && (shl != SROREG))
+		if ((shl = tshapem(l, q->lshape)) != SRDIR && (shl != SROREG))
 			continue;
 
 		F2DEBUG(("findmops lshape %s\n", srtyp[shl]));
@@ -24,6 +24,8 @@ int chkop[DSIZE];
 
 void mktables(void);
 
+#define	MAXOPLST	256	/* max table entries for one op */
+
 char *ftitle;
 char *cname = "external.c";
 char *hname = "external.h";
@@ -440,16 +442,16 @@ if (bitsz == 64) {
 	nelem = (MAXREGS+bitsz-1)/bitsz;
 	fprintf(fc, "static bittype ovlarr[MAXREGS][%d] = {\n", nelem);
 	for (i = 0; i < MAXREGS; i++) {
-		int el[10];
+		long el[10];
 		memset(el, 0, sizeof(el));
-		el[i/bitsz] = 1 << (i % bitsz);
+		el[i/bitsz] = (long)1 << (i % bitsz);
 		for (j = 0; roverlay[i][j] >= 0; j++) {
 			int k = roverlay[i][j];
-			el[k/bitsz] |= (1 << (k % bitsz));
+			el[k/bitsz] |= ((long)1 << (k % bitsz));
 		}
 		fprintf(fc, "{ ");
 		for (j = 0; j < MAXREGS; j += bitsz)
-			fprintf(fc, "0x%x, ", el[j/bitsz]);
+			fprintf(fc, "0x%lx, ", el[j/bitsz]);
 		fprintf(fc, " },\n");
 	}
 	fprintf(fc, "};\n");
@@ -464,51 +466,207 @@ if (bitsz == 64) {
 
 #define	P(x)	fprintf x
 
+/*
+ * Return a type in type class c.
+ */
+static TWORD
+tcrep(int c)
+{
+	TWORD t;
+	int b = c % TC_PTR;
+
+	if (b == TC_PFTN)
+		t = INCREF(FTN|INT);
+	else if (b == TC_POINT)
+		t = c >= TC_PTR ? INCREF(INT) : ARY|INT;
+	else
+		t = b;
+	return c >= TC_PTR ? INCREF(t) : t;
+}
+
+#define	NTWORD	64	/* max different type words in the table */
+
+static int ntword, tword[NTWORD];
+
+static int
+twidx(int tw)
+{
+	int i;
+
+	for (i = 0; i < ntword; i++)
+		if (tword[i] == tw)
+			return i;
+	if (ntword == NTWORD) {
+		fprintf(stderr, "mkext: too many type words\n");
+		exit(1);
+	}
+	tword[ntword] = tw;
+	return ntword++;
+}
+
+/*
+ * Make the instruction selection index.  For each op, left type class
+ * and right type class there is a list of the table entries that the
+ * types match, in table order.  Classes that no type word in the table
+ * tells apart are merged first.  Equal lists are only stored once.
+ */
+#define	IXHASH	1024
+
+struct ixl {
+	struct ixl *next;
+	int off, len;
+} *ixhash[IXHASH];
+
+static int *ixpool, ixplen, ixpsz;
+
+static int
+ixadd(int *l, int n)
+{
+	struct ixl *ix;
+	unsigned int h = n;
+	int i;
+
+	for (i = 0; i < n; i++)
+		h = h * 31 + l[i];
+	h %= IXHASH;
+	for (ix = ixhash[h]; ix; ix = ix->next)
+		if (ix->len == n &&
+		    memcmp(&ixpool[ix->off], l, n * sizeof(int)) == 0)
+			return ix->off;
+	if (ixplen + n + 1 > ixpsz) {
+		ixpsz = (ixplen + n + 1) * 2;
+		if ((ixpool = realloc(ixpool, ixpsz * sizeof(int))) == NULL) {
+			fprintf(stderr, "mkext: out of memory\n");
+			exit(1);
+		}
+	}
+	memcpy(&ixpool[ixplen], l, n * sizeof(int));
+	ixpool[ixplen + n] = -1;
+	ix = malloc(sizeof(struct ixl));
+	ix->off = ixplen;
+	ix->len = n;
+	ix->next = ixhash[h];
+	ixhash[h] = ix;
+	ixplen += n + 1;
+	return ix->off;
+}
+
+static void
+mkindex(int *oplist[], int oplen[])
+{
+	static char sig[NTCLASS][NTWORD];
+	int tcmap[NTCLASS], tcrepr[NTCLASS];
+	int *li, *ri, l[MAXOPLST];
+	struct optab *q;
+	int i, j, k, n, lc, rc, ntc;
+
+	n = 0;
+	for (q = table; q->op != FREE; q++)
+		n++;
+	li = malloc(n * sizeof(int));
+	ri = malloc(n * sizeof(int));
+	for (i = 0; i < n; i++) {
+		li[i] = twidx(table[i].ltype);
+		ri[i] = twidx(table[i].rtype);
+	}
+
+	/* which type words each class matches */
+	for (i = 0; i < NTCLASS; i++) {
+		if (i < TC_ANY && tclass(tcrep(i)) != i) {
+			fprintf(stderr, "mkext: bad type class %d\n", i);
+			exit(1);
+		}
+		for (j = 0; j < ntword; j++)
+			sig[i][j] = i == TC_ANY ||
+			    ttype(tcrep(i), tword[j]) != 0;
+	}
+	for (ntc = i = 0; i < NTCLASS; i++) {
+		for (j = 0; j < ntc; j++)
+			if (memcmp(sig[i], sig[tcrepr[j]], ntword) == 0)
+				break;
+		if (j == ntc)
+			tcrepr[ntc++] = i;
+		tcmap[i] = j;
+	}
+
+	P((fc, "unsigned char tcmap[] = {"));
+	for (i = 0; i < NTCLASS; i++)
+		P((fc, "%s%d,", i % 16 ? " " : "\n\t", tcmap[i]));
+	P((fc, "\n};\n"));
+
+	(void)ixadd(l, 0);
+	P((fc, "unsigned short qixoff[] = {"));
+	for (i = k = 0; i <= MAXOP; i++) {
+		for (lc = 0; lc < ntc; lc++) {
+			for (rc = 0; rc < ntc; rc++) {
+				for (n = j = 0; j < oplen[i]; j++) {
+					int e = oplist[i][j];
+
+					if (sig[tcrepr[lc]][li[e]] &&
+					    sig[tcrepr[rc]][ri[e]])
+						l[n++] = e;
+				}
+				P((fc, "%s%d,", k++ % 12 ? " " : "\n\t",
+				    ixadd(l, n)));
+			}
+		}
+	}
+	P((fc, "\n};\n"));
+	if (ixplen > 65535) {
+		fprintf(stderr, "mkext: index pool too large\n");
+		exit(1);
+	}
+
+	P((fc, "int qixpool[] = {"));
+	for (i = 0; i < ixplen; i++)
+		P((fc, "%s%d,", i % 12 ? " " : "\n\t", ixpool[i]));
+	P((fc, "\n};\n"));
+
+	P((fh, "#define NTCMAP %d\n", ntc));
+	P((fh, "extern unsigned char tcmap[];\n"));
+	P((fh, "extern unsigned short qixoff[];\n"));
+	P((fh, "extern int qixpool[];\n"));
+	free(li);
+	free(ri);
+}
+
 void
 mktables(void)
 {
 	struct optab *op;
+	int *oplist[MAXOP+1], oplen[MAXOP+1];
 	int mxalen = 0, curalen;
 	int i;
 
-#if 0
-	P((fc, "#include \"pass2.h\"\n\n"));
-#endif
 	for (i = 0; i <= MAXOP; i++) {
 		curalen = 0;
-		P((fc, "static int op%d[] = { ", i));
+		oplist[i] = malloc(MAXOPLST * sizeof(int));
 		if (dope[i] != 0)
 		for (op = table; op->op != FREE; op++) {
 			if (op->op < OPSIMP) {
-				if (op->op == i) {
-					P((fc, FMTdPTR ", ", op - table));
-					curalen++;
-				}
+				if (op->op == i)
+					oplist[i][curalen++] = op - table;
 			} else {
 				int opmtemp;
 				if ((opmtemp=mamask[op->op - OPSIMP])&SPFLG) {
 					if (i==NAME || i==ICON || i==TEMP ||
-					    i==OREG || i == REG || i == FCON) {
-						P((fc, FMTdPTR ", ",
-						    op - table));
-						curalen++;
-					}
+					    i==OREG || i == REG || i == FCON)
+						oplist[i][curalen++] = op - table;
 				} else if ((dope[i]&(opmtemp|ASGFLG))==opmtemp){
-					P((fc, FMTdPTR ", ", op - table));
-					curalen++;
+					oplist[i][curalen++] = op - table;
 				}
 			}
+			if (curalen == MAXOPLST) {
+				fprintf(stderr, "mkext: too many entries for op %d\n", i);
+				exit(1);
+			}
 		}
+		oplen[i] = curalen;
 		if (curalen > mxalen)
 			mxalen = curalen;
-		P((fc, "-1 };\n"));
-	}
-	P((fc, "\n"));
-
-	P((fc, "int *qtable[] = { \n"));
-	for (i = 0; i <= MAXOP; i++) {
-		P((fc, "	op%d,\n", i));
 	}
-	P((fc, "};\n"));
+	mkindex(oplist, oplen);
+	for (i = 0; i <= MAXOP; i++)
+		free(oplist[i]);
 	P((fh, "#define MAXOPLEN %d\n", mxalen+1));
 }
@@ -87,9 +87,9 @@ static void add_labels(struct p2env*) ;
 /* Perform trace scheduling, try to get rid of gotos as much as possible */
 void TraceSchedule(struct p2env*) ;
 
-#ifdef ENABLE_NEW
-static void do_cse(struct p2env* p2e) ;
-#endif
+static void do_cse(struct p2env *);
+static void loopopt(struct p2env *);
+static void findloops(struct p2env *);
 
 /* Walk the complete set, performing a function on each node. 
  * if type is given, apply function on only that type */
@@ -119,9 +119,6 @@ optimize(struct p2env *p2e)
 
 	if (xssa)
 		add_labels(p2e) ;
-#ifdef ENABLE_NEW
-	do_cse(p2e);
-#endif
 
 #ifdef PCC_DEBUG
 	if (b2debug) {
@@ -219,6 +216,18 @@ optimize(struct p2env *p2e)
 		}
 #endif
 	}
+	if (xloop && (xssa || xtemps)) {
+		BDEBUG(("Calling loopopt\n"));
+		loopopt(p2e);
+	} else if (xssa || xtemps) {
+		/* loop depths are still wanted for the spill costs */
+		dominators(p2e);
+		findloops(p2e);
+	}
+	if (xcse && (xssa || xtemps)) {
+		BDEBUG(("Calling do_cse\n"));
+		do_cse(p2e);
+	}
 	myoptim(ipole);
 }
 
@@ -737,6 +746,7 @@ bblocks_build(struct p2env *p2e)
 			bb->dfchildren = NULL;
 			bb->Aorig = NULL;
 			bb->Aphi = NULL;
+			bb->loopdepth = 0;
 			SLIST_INIT(&bb->phi);
 			bb->bbnum = count;
 			DLIST_INSERT_BEFORE(&p2e->bblocks, bb, bbelem);
@@ -1195,7 +1205,7 @@ placePhiFunctions(struct p2env *p2e)
 					    y->dfnum,y->bbnum,y,i+defsites.low);
 
 					/* If no live in, no phi node needed */
-					if (!TESTBIT(y->in,
+					if (!lstest(y->in,
 					    (i+defsites.low-p2e->ipp->ip_tmpnum+MAXREGS))) {
 					if (b2debug)
 					printf("tmp %d bb %d unused, no phi\n",
@@ -2059,205 +2069,1976 @@ static void add_labels(struct p2env* p2e)
 	}
 }
 
-/* node map */
-#ifdef ENABLE_NEW
-struct node_map {
-	NODE* node ;		/* the node */
-	unsigned int node_num ; /* node is equal to that one */
-	unsigned int var_num ;	/* node computes this variable */
-} ;
+/*
+ * Common subexpression elimination.
+ *
+ * Expressions built only from temporaries, constants and the frame
+ * pointer are hashed while walking the dominator tree.  When one is
+ * seen again, all later occurrences are replaced with a temporary that
+ * is assigned just before the statement where it first occurred.
+ * Memory references and other hard registers are never part of an
+ * expression, so stores, calls and volatile objects cannot change its
+ * value.
+ *
+ * Inside a basic block an expression is valid until one of its
+ * temporaries is assigned.  It is also valid in the dominated blocks
+ * if each of its temporaries has a single definition that dominates
+ * the expression.
+ */
+#define	CSEHSZ	256
+
+/*
+ * Is the object p refers to volatile?  Scalars keep their own
+ * qualifier one level down, see tprint().
+ */
+#define	OBJVOL(p)	((p)->n_type > BTMASK ? ISVOL((p)->n_qual) : \
+	ISVOL((p)->n_qual << TSHIFT))
+
+struct cse {
+	struct cse *next;	/* hash chain */
+	struct cse *prev;	/* scope stack */
+	struct cse *link;	/* all entries, in creation order */
+	NODE *p;		/* first occurrence */
+	struct interpass *ip;	/* statement it occurs in */
+	struct basicblock *bb;
+	int hash;
+	int stamp;		/* statement number */
+	int global;		/* also valid in dominated blocks */
+	int nuse;
+	int tnum;		/* temp holding the value */
+};
+
+struct cseuse {
+	struct cseuse *next;
+	struct cse *e;
+	NODE *p;
+};
+
+static struct cse *csetab[CSEHSZ], *csetop, *csefirst, *cselast;
+static struct cseuse *cseuses;
+static struct basicblock *csecur;
+static int *csendef, *csetime, csemin, csemax, csestamp;
+static bittype *csedom;
+
+/*
+ * Return 1 if p only computes a value from temporaries and constants.
+ */
+static int
+csepure(NODE *p)
+{
+	if (szty(p->n_type) != 1 || OBJVOL(p))
+		return 0;
+	switch (p->n_op) {
+	case TEMP:
+		return regno(p) >= csemin && regno(p) < csemax;
+	case REG:
+		return regno(p) == FPREG;
+	case ICON:
+		return 1;
+	case UMINUS:
+	case COMPL:
+	case SCONV:
+	case PCONV:
+		return csepure(p->n_left);
+	case PLUS:
+	case MINUS:
+	case MUL:
+	case DIV:
+	case MOD:
+	case AND:
+	case OR:
+	case ER:
+	case LS:
+	case RS:
+		return csepure(p->n_left) && csepure(p->n_right);
+	}
+	return 0;
+}
 
-static unsigned long nodes_counter ;
-static void node_map_count_walker(NODE* n, void* x)
+/*
+ * Rough number of instructions needed to compute p.  A temp plus a
+ * constant usually ends up as an offset or an immediate, so it is
+ * not worth keeping in a register by itself.
+ */
+static int
+csecost(NODE *p)
 {
-	nodes_counter ++ ;
+	int c;
+
+	switch (optype(p->n_op)) {
+	case LTYPE:
+		if (p->n_op == NAME || p->n_op == OREG)
+			return 2;
+		if (p->n_op == REG)
+			return 1;
+		return p->n_op == ICON && p->n_name[0] != '\0';
+	case UTYPE:
+		c = p->n_op != SCONV && p->n_op != PCONV;
+		return c + csecost(p->n_left);
+	}
+	c = p->n_op == MUL || p->n_op == DIV || p->n_op == MOD ? 3 : 1;
+	return c + csecost(p->n_left) + csecost(p->n_right);
 }
 
-static void do_cse(struct p2env* p2e)
+static unsigned int
+csehash(NODE *p)
 {
-	nodes_counter = 0 ;
-	WalkAll(p2e, node_map_count_walker, 0, 0) ;
-	BDEBUG(("Found %ld nodes\n", nodes_counter)) ;
+	unsigned int h = p->n_op * 31 + p->n_type;
+	char *s;
+
+	switch (optype(p->n_op)) {
+	case LTYPE:
+		if (p->n_op == TEMP || p->n_op == REG)
+			return h * 17 + regno(p);
+		h = h * 17 + (unsigned int)getlval(p);
+		for (s = p->n_name; *s; s++)
+			h = h * 31 + *s;
+		return h;
+	case UTYPE:
+		return h * 17 + csehash(p->n_left);
+	}
+	h = h * 17 + csehash(p->n_left);
+	return h * 17 + csehash(p->n_right);
 }
-#endif
 
-#define BITALLOC(ptr,all,sz) { \
-	int sz__s = BIT2BYTE(sz); ptr = all(sz__s); memset(ptr, 0, sz__s); }
-#define VALIDREG(p)	(p->n_op == REG && TESTBIT(validregs, regno(p)))
-#define XCHECK(x) if (x < 0 || x >= xbits) printf("x out of range %d\n", x)
-#define RUP(x) (((x)+NUMBITS-1)/NUMBITS)
-#define SETCOPY(t,f,i,n) for (i = 0; i < RUP(n); i++) t[i] = f[i]
-#define SETSET(t,f,i,n) for (i = 0; i < RUP(n); i++) t[i] |= f[i]
-#define SETCLEAR(t,f,i,n) for (i = 0; i < RUP(n); i++) t[i] &= ~f[i]
-#define SETCMP(v,t,f,i,n) for (i = 0; i < RUP(n); i++) \
-	if (t[i] != f[i]) v = 1
+static int
+csecmp(NODE *p, NODE *q)
+{
+	if (p->n_op != q->n_op || p->n_type != q->n_type)
+		return 0;
+	switch (optype(p->n_op)) {
+	case LTYPE:
+		if (p->n_op == TEMP || p->n_op == REG)
+			return regno(p) == regno(q);
+		return getlval(p) == getlval(q) &&
+		    strcmp(p->n_name, q->n_name) == 0;
+	case UTYPE:
+		return csecmp(p->n_left, q->n_left);
+	}
+	return csecmp(p->n_left, q->n_left) && csecmp(p->n_right, q->n_right);
+}
 
-static int xxx, xbits;
 /*
- * Set/clear long term liveness for regs and temps.
+ * Return 1 if no temp in p has been assigned since statement stamp.
  */
-static void
-unionize(NODE *p, struct basicblock *bb, int suboff)
+static int
+csekept(NODE *p, int stamp)
 {
-	int o, ty;
-
-	if ((o = p->n_op) == TEMP || VALIDREG(p)) {
-		int b = regno(p);
-		if (o == TEMP)
-			b = b - suboff + MAXREGS;
-XCHECK(b);
-		BITSET(bb->gen, b);
+	switch (optype(p->n_op)) {
+	case LTYPE:
+		return p->n_op != TEMP || csetime[regno(p) - csemin] < stamp;
+	case UTYPE:
+		return csekept(p->n_left, stamp);
 	}
-	if (asgop(o)) {
-		if (p->n_left->n_op == TEMP || VALIDREG(p)) {
-			int b = regno(p->n_left);
-			if (p->n_left->n_op == TEMP)
-				b = b - suboff + MAXREGS;
-XCHECK(b);
-			BITCLEAR(bb->gen, b);
-			BITSET(bb->killed, b);
-			unionize(p->n_right, bb, suboff);
-			return;
-		}
+	return csekept(p->n_left, stamp) && csekept(p->n_right, stamp);
+}
+
+/*
+ * Return 1 if all temps in p have a single, dominating, definition.
+ */
+static int
+cseglobal(NODE *p)
+{
+	int t;
+
+	switch (optype(p->n_op)) {
+	case LTYPE:
+		if (p->n_op != TEMP)
+			return 1;
+		t = regno(p) - csemin;
+		return csendef[t] == 1 && TESTBIT(csedom, t);
+	case UTYPE:
+		return cseglobal(p->n_left);
 	}
-	ty = optype(o);
-	if (ty != LTYPE)
-		unionize(p->n_left, bb, suboff);
-	if (ty == BITYPE)
-		unionize(p->n_right, bb, suboff);
+	return cseglobal(p->n_left) && cseglobal(p->n_right);
 }
 
 /*
- * Found an extended assembler node, so growel out gen/killed nodes.
+ * Find temps written by a statement.  arg is 0 to count definitions,
+ * 1 to record them and 2 to forget them when leaving a block.
  */
 static void
-xasmionize(NODE *p, void *arg)
+csedef(NODE *p, void *arg)
 {
-	struct basicblock *bb = arg;
-	int cw, b;
-
-	if (p->n_op == ICON && p->n_type == STRTY)
-		return; /* dummy end marker */
+	int t;
 
-	cw = xasmcode(p->n_name);
-	if (XASMVAL(cw) == 'n' || XASMVAL(cw) == 'm')
-		return; /* no flow analysis */
+	if (p->n_op != ASSIGN && p->n_op != XARG)
+		return;
 	p = p->n_left;
- 
-	if (XASMVAL(cw) == 'g' && p->n_op != TEMP && p->n_op != REG)
-		return; /* no flow analysis */
+	if (p->n_op != TEMP || regno(p) < csemin || regno(p) >= csemax)
+		return;
+	t = regno(p) - csemin;
+	switch (*(int *)arg) {
+	case 0:
+		csendef[t]++;
+		break;
+	case 1:
+		csetime[t] = csestamp;
+		BITSET(csedom, t);
+		break;
+	case 2:
+		BITCLEAR(csedom, t);
+		break;
+	}
+}
 
-	b = regno(p);
-#if 0
-	if (XASMVAL(cw) == 'r' && p->n_op == TEMP)
-		addnotspill(b);
-#endif
-#define MKTOFF(r)	((r) - xxx)
-	if (XASMISOUT(cw)) {
-		if (p->n_op == TEMP) {
-			BITCLEAR(bb->gen, MKTOFF(b));
-			BITSET(bb->killed, MKTOFF(b));
-		} else if (p->n_op == REG) {
-			BITCLEAR(bb->gen, b);
-			BITSET(bb->killed, b);	 
-		} else
-			uerror("bad xasm node type %d", p->n_op);
+/*
+ * Return 1 if p contains no assignments.
+ */
+static int
+csenoasg(NODE *p)
+{
+	switch (p->n_op) {
+	case ASSIGN:
+	case STASG:
+	case XASM:
+		return 0;
 	}
-	if (XASMISINP(cw)) {
-		if (p->n_op == TEMP) {
-			BITSET(bb->gen, MKTOFF(b));
-		} else if (p->n_op == REG) {
-			BITSET(bb->gen, b);
-		} else if (optype(p->n_op) != LTYPE) {
-			if (XASMVAL(cw) == 'r')
-				uerror("couldn't find available register");
-			else
-				uerror("bad xasm node type2");
+	switch (optype(p->n_op)) {
+	case UTYPE:
+		return csenoasg(p->n_left);
+	case BITYPE:
+		return csenoasg(p->n_left) && csenoasg(p->n_right);
+	}
+	return 1;
+}
+
+/*
+ * Expressions are only picked up in statements without embedded
+ * assignments, where the evaluation order does not matter.  A chain
+ * of assignments is fine since its right side is evaluated first.
+ */
+static int
+csesafe(NODE *p)
+{
+	for (; p->n_op == ASSIGN; p = p->n_right)
+		if (!csenoasg(p->n_left))
+			return 0;
+	return csenoasg(p);
+}
+
+static void
+csenode(NODE *p, struct interpass *ip)
+{
+	NODE *r = ip->ip_node;
+	struct cseuse *u;
+	struct cse *e;
+	unsigned int h = 0;
+	int o, cand;
+
+	if ((cand = csepure(p) && csecost(p) > 1)) {
+		h = csehash(p) % CSEHSZ;
+		for (e = csetab[h]; e; e = e->next) {
+			if (!csecmp(e->p, p))
+				continue;
+			if (e->global ||
+			    (e->bb == csecur && csekept(e->p, e->stamp)))
+				break;
+		}
+		if (e != NULL) {
+			u = tmpalloc(sizeof(struct cseuse));
+			u->e = e;
+			u->p = p;
+			u->next = cseuses;
+			cseuses = u;
+			e->nuse++;
+			return;
 		}
 	}
+
+	o = optype(p->n_op);
+	if (o != LTYPE)
+		csenode(p->n_left, ip);
+	if (o == BITYPE)
+		csenode(p->n_right, ip);
+
+	if (!cand)
+		return;
+	e = tmpalloc(sizeof(struct cse));
+	e->p = p;
+	e->ip = ip;
+	e->bb = csecur;
+	e->hash = h;
+	e->stamp = csestamp;
+	e->global = cseglobal(p);
+	e->nuse = 0;
+	e->tnum = 0;
+	/* "t = expr" with a single-assigned t can use t directly */
+	if (r->n_op == ASSIGN && r->n_right == p &&
+	    r->n_left->n_op == TEMP && r->n_left->n_type == p->n_type &&
+	    regno(r->n_left) >= csemin && regno(r->n_left) < csemax &&
+	    csendef[regno(r->n_left) - csemin] == 1)
+		e->tnum = regno(r->n_left);
+	e->next = csetab[h];
+	csetab[h] = e;
+	e->prev = csetop;
+	csetop = e;
+	e->link = NULL;
+	if (cselast)
+		cselast->link = e;
+	else
+		csefirst = e;
+	cselast = e;
 }
 
 /*
- * Do variable liveness analysis.  Only analyze the long-lived
- * variables, and save the live-on-exit temporaries in a bit-field
- * at the end of each basic block. This bit-field is later used
- * when doing short-range liveness analysis in Build().
+ * Walk the dominator tree, collecting expressions.
  */
-void
-liveanal(struct p2env *p2e)
+static void
+cseblock(struct p2env *p2e, struct basicblock *bb)
 {
-	struct basicblock *bb;
 	struct interpass *ip;
-	bittype *saved;
-	int mintemp, again;
+	int h, mode;
+
+	csecur = bb;
+	mode = 1;
+	for (ip = bb->first; ; ip = DLIST_NEXT(ip, qelem)) {
+		if (ip->type == IP_NODE) {
+			csestamp++;
+			if (csesafe(ip->ip_node))
+				csenode(ip->ip_node, ip);
+			walkf(ip->ip_node, csedef, &mode);
+		}
+		if (ip == bb->last)
+			break;
+	}
 
-	xbits = p2e->epp->ip_tmpnum - p2e->ipp->ip_tmpnum + MAXREGS;
-	mintemp = p2e->ipp->ip_tmpnum;
+	for (h = 1; h < p2e->bbinfo.size; h++)
+		if (TESTBIT(bb->dfchildren, h))
+			cseblock(p2e, p2e->bbinfo.arr[h]);
 
-	/* Just fetch space for the temporaries from heap */
-	DLIST_FOREACH(bb, &p2e->bblocks, bbelem) {
-		BITALLOC(bb->gen,tmpalloc,xbits);
-		BITALLOC(bb->killed,tmpalloc,xbits);
-		BITALLOC(bb->in,tmpalloc,xbits);
-		BITALLOC(bb->out,tmpalloc,xbits);
+	/* leave scope */
+	while (csetop != NULL && csetop->bb == bb) {
+		csetab[csetop->hash] = csetop->next;
+		csetop = csetop->prev;
+	}
+	mode = 2;
+	for (ip = bb->first; ; ip = DLIST_NEXT(ip, qelem)) {
+		if (ip->type == IP_NODE)
+			walkf(ip->ip_node, csedef, &mode);
+		if (ip == bb->last)
+			break;
 	}
-	BITALLOC(saved,tmpalloc,xbits);
+}
+
+static void
+csetemp(NODE *p, int tnum)
+{
+	p->n_op = TEMP;
+	p->n_name = "";
+	setlval(p, 0);
+	regno(p) = tnum;
+}
+
+static void
+do_cse(struct p2env *p2e)
+{
+	struct interpass *ip, *nip;
+	struct cseuse *u;
+	struct cse *e;
+	NODE *p;
+	int mode, n, nexpr;
+
+	csemin = p2e->ipp->ip_tmpnum;
+	csemax = p2e->epp->ip_tmpnum;
+	if (csemax == csemin)
+		return;
+
+	dominators(p2e);
+
+	n = csemax - csemin;
+	csendef = tmpalloc(n * sizeof(int));
+	csetime = tmpalloc(n * sizeof(int));
+	memset(csendef, 0, n * sizeof(int));
+	memset(csetime, 0, n * sizeof(int));
+	csedom = setalloc(n);
+	memset(csetab, 0, sizeof(csetab));
+	csetop = csefirst = cselast = NULL;
+	cseuses = NULL;
+	csestamp = 0;
+
+	mode = 0;
+	DLIST_FOREACH(ip, &p2e->ipole, qelem)
+		if (ip->type == IP_NODE)
+			walkf(ip->ip_node, csedef, &mode);
+
+	cseblock(p2e, DLIST_NEXT(&p2e->bblocks, bbelem));
 
-	xxx = mintemp;
 	/*
-	 * generate the gen-killed sets for all basic blocks.
+	 * Assign the first occurrences to temps.  Entries are created
+	 * bottom-up, so inner expressions are moved out first.
 	 */
-	DLIST_FOREACH(bb, &p2e->bblocks, bbelem) {
-		for (ip = bb->last; ; ip = DLIST_PREV(ip, qelem)) {
-			/* gen/killed is 'p', this node is 'n' */
-			if (ip->type == IP_NODE) {
-				if (ip->ip_node->n_op == XASM)
-					flist(ip->ip_node->n_left,
-					    xasmionize, bb);
-				else
-					unionize(ip->ip_node, bb, mintemp);
+	nexpr = 0;
+	for (e = csefirst; e; e = e->link) {
+		if (e->nuse == 0 || e->tnum != 0)
+			continue;
+		nexpr++;
+		e->tnum = p2e->epp->ip_tmpnum++;
+		p = talloc();
+		*p = *e->p;
+		nip = ipnode(mkbinode(ASSIGN,
+		    mktemp(e->tnum, p->n_type), p, p->n_type));
+		nip->lineno = e->ip->lineno;
+		DLIST_INSERT_BEFORE(e->ip, nip, qelem);
+		if (e->bb->first == e->ip)
+			e->bb->first = nip;
+		csetemp(e->p, e->tnum);
+	}
+	n = 0;
+	for (u = cseuses; u; u = u->next) {
+		p = u->p;
+		if (optype(p->n_op) == BITYPE)
+			tfree(p->n_right);
+		tfree(p->n_left);
+		csetemp(p, u->e->tnum);
+		n++;
+	}
+	BDEBUG(("do_cse: %d new temps, %d expressions replaced\n", nexpr, n));
+}
+
+/*
+ * Loop optimizations.
+ *
+ * Natural loops are found from back edges to a dominating block.
+ * Loops sharing a header are merged, and the loops are kept outermost
+ * first with a link to the enclosing loop.  Each block gets the number
+ * of loops it is in.
+ */
+struct loop {
+	struct loop *next;	/* outermost first */
+	struct loop *parent;	/* enclosing loop */
+	struct basicblock *header;
+	bittype *body;		/* member blocks, by dfnum */
+	int nblocks;
+	int depth;
+};
+
+static struct loop *loops;
+
+/*
+ * Return 1 if block a dominates block b.
+ */
+static int
+dominates(struct p2env *p2e, struct basicblock *a, struct basicblock *b)
+{
+	while (b != a && b->idom != 0)
+		b = p2e->bbinfo.arr[b->idom];
+	return b == a;
+}
+
+static void
+findloops(struct p2env *p2e)
+{
+	struct basicblock *bb, *h, **stk;
+	struct cfgnode *cn;
+	struct loop *l, *m, **lp;
+	int i, sp;
+
+	loops = NULL;
+	DLIST_FOREACH(bb, &p2e->bblocks, bbelem)
+		bb->loopdepth = 0;
+	stk = tmpalloc(p2e->bbinfo.size * sizeof(struct basicblock *));
+
+	for (i = 1; i < p2e->bbinfo.size; i++) {
+		bb = p2e->bbinfo.arr[i];
+		SLIST_FOREACH(cn, &bb->child, chld) {
+			h = cn->bblock;
+			if (h->dfnum == 0 || !dominates(p2e, h, bb))
+				continue;
+			/* back edge bb -> h */
+			for (l = loops; l; l = l->next)
+				if (l->header == h)
+					break;
+			if (l == NULL) {
+				l = tmpalloc(sizeof(struct loop));
+				l->header = h;
+				l->body = setalloc(p2e->bbinfo.size);
+				BITSET(l->body, h->dfnum);
+				l->nblocks = 1;
+				l->next = loops;
+				loops = l;
 			}
-			if (ip == bb->first)
-				break;
-		}
-		memcpy(bb->in, bb->gen, BIT2BYTE(xbits));
-#ifdef PCC_DEBUG
-#define PRTRG(x) printf("%d ", x < MAXREGS ? x : x + p2e->ipp->ip_tmpnum-MAXREGS)
-		if (b2debug > 1) {
-			int i;
+			sp = 0;
+			if (!TESTBIT(l->body, bb->dfnum)) {
+				BITSET(l->body, bb->dfnum);
+				l->nblocks++;
+				stk[sp++] = bb;
+			}
+			while (sp > 0) {
+				struct cfgnode *pn;
 
-			printf("basic block %d\ngen: ", bb->bbnum);
-			for (i = 0; i < xbits; i++)
-				if (TESTBIT(bb->gen, i))
-					PRTRG(i);
-			printf("\nkilled: ");
-			for (i = 0; i < xbits; i++)
-				if (TESTBIT(bb->killed, i))
-					PRTRG(i);
-			printf("\n");
+				SLIST_FOREACH(pn, &stk[--sp]->parents, cfgelem) {
+					struct basicblock *p = pn->bblock;
+
+					if (p->dfnum == 0 || TESTBIT(l->body, p->dfnum))
+						continue;
+					BITSET(l->body, p->dfnum);
+					l->nblocks++;
+					stk[sp++] = p;
+				}
+			}
 		}
-#endif
 	}
-	/* do liveness analysis on basic block level */
-	do {
-		struct cfgnode *cn;
-		int j;
-
-		again = 0;
-		/* XXX - loop should be in reversed execution-order */
-		DLIST_FOREACH_REVERSE(bb, &p2e->bblocks, bbelem) {
-			SETCOPY(saved, bb->out, j, xbits);
-			SLIST_FOREACH(cn, &bb->child, chld) {
-				SETSET(bb->out, cn->bblock->in, j, xbits);
+
+	/* sort outermost first; an enclosing loop has more blocks */
+	m = loops;
+	loops = NULL;
+	while (m != NULL) {
+		l = m;
+		m = m->next;
+		for (lp = &loops; *lp && (*lp)->nblocks >= l->nblocks;
+		    lp = &(*lp)->next)
+			;
+		l->next = *lp;
+		*lp = l;
+	}
+	for (l = loops; l; l = l->next) {
+		l->parent = NULL;
+		l->depth = 1;
+		for (m = loops; m != l; m = m->next)
+			if (TESTBIT(m->body, l->header->dfnum)) {
+				l->parent = m;
+				l->depth = m->depth + 1;
 			}
-			SETCMP(again, saved, bb->out, j, xbits);
-			SETCOPY(saved, bb->in, j, xbits);
-			SETCOPY(bb->in, bb->out, j, xbits);
-			SETCLEAR(bb->in, bb->killed, j, xbits);
-			SETSET(bb->in, bb->gen, j, xbits);
-			SETCMP(again, saved, bb->in, j, xbits);
-		}
-	} while (again);
+		for (i = 1; i < p2e->bbinfo.size; i++)
+			if (TESTBIT(l->body, i))
+				p2e->bbinfo.arr[i]->loopdepth++;
+		BDEBUG(("loop header %d, %d blocks, depth %d\n",
+		    l->header->dfnum, l->nblocks, l->depth));
+	}
+}
+
+/*
+ * Add a preheader in front of the loop header, so that the loop is
+ * only entered through it.  Jumps from outside the loop are redirected
+ * to the new label, and a block inside the loop that falls into the
+ * header gets an explicit jump.  Returns the statement to insert
+ * hoisted code in front of, or NULL if the header cannot be split.
+ * Nothing is changed unless doit is set.
+ */
+static struct interpass *
+mkpreheader(struct loop *l, int doit)
+{
+	struct basicblock *h = l->header, *bb, *fall;
+	struct interpass *ip, *prev;
+	struct cfgnode *cn;
+	NODE *p;
+	int lab, nlab;
+
+	if (h->first->type != IP_DEFLAB)
+		return NULL;
+	lab = h->first->ip_lbl;
+	prev = DLIST_PREV(h->first, qelem);
+	fall = NULL;
+	SLIST_FOREACH(cn, &h->parents, cfgelem) {
+		bb = cn->bblock;
+		ip = bb->last;
+		p = ip->type == IP_NODE ? ip->ip_node : NULL;
+		if (p && p->n_op == GOTO && p->n_left->n_op != ICON)
+			return NULL;
+		if (bb->dfnum && TESTBIT(l->body, bb->dfnum)) {
+			if (ip == prev && (p == NULL || p->n_op != GOTO))
+				fall = bb;
+		} else if (ip != prev && (p == NULL ||
+		    (p->n_op != GOTO && p->n_op != CBRANCH)))
+			return NULL;
+	}
+
+	if (!doit)
+		return h->first;
+
+	nlab = getlab2();
+	SLIST_FOREACH(cn, &h->parents, cfgelem) {
+		bb = cn->bblock;
+		if (bb->dfnum && TESTBIT(l->body, bb->dfnum))
+			continue;
+		if (bb->last->type != IP_NODE)
+			continue;
+		p = bb->last->ip_node;
+		if (p->n_op == GOTO && getlval(p->n_left) == lab)
+			setlval(p->n_left, nlab);
+		else if (p->n_op == CBRANCH && getlval(p->n_right) == lab)
+			setlval(p->n_right, nlab);
+	}
+	if (fall != NULL) {
+		ip = ipnode(mkunode(GOTO, mklnode(ICON, lab, 0, INT), 0, INT));
+		DLIST_INSERT_AFTER(fall->last, ip, qelem);
+		fall->last = ip;
+	}
+	ip = tmpalloc(sizeof(struct interpass));
+	ip->type = IP_DEFLAB;
+	ip->lineno = h->first->lineno;
+	ip->ip_lbl = nlab;
+	DLIST_INSERT_BEFORE(h->first, ip, qelem);
+	return h->first;
+}
+
+/*
+ * Loop-invariant code motion.  Expressions whose temps are not
+ * assigned in the loop are computed once in a preheader.  Loads of
+ * global and stack variables are also moved if nothing in the loop
+ * writes memory or calls a function.  Only operations that cannot
+ * trap are moved, since the loop body might not have executed them.
+ */
+struct licm {
+	struct licm *next;
+	NODE *p;		/* expression computed in the preheader */
+	int tnum;
+};
+
+static bittype *licmdefs;
+static int licmmem, licmtmin, licmtmax;
+
+static void
+licmscan(NODE *p, void *arg)
+{
+	NODE *l;
+	int t;
+
+	if (callop(p->n_op) || p->n_op == STASG || p->n_op == XASM)
+		licmmem = 1;
+	if (p->n_op != ASSIGN && p->n_op != XARG)
+		return;
+	l = p->n_left;
+	if (l->n_op == TEMP) {
+		t = regno(l) - licmtmin;
+		if (t >= 0 && regno(l) < licmtmax)
+			BITSET(licmdefs, t);
+	} else if (l->n_op != REG)
+		licmmem = 1;
+}
+
+static int
+licminv(NODE *p)
+{
+	int t;
+
+	if (szty(p->n_type) != 1 || OBJVOL(p))
+		return 0;
+	switch (p->n_op) {
+	case TEMP:
+		if (regno(p) < licmtmin || regno(p) >= licmtmax)
+			return regno(p) >= licmtmax;
+		t = regno(p) - licmtmin;
+		return !TESTBIT(licmdefs, t);
+	case ICON:
+		return 1;
+	case REG:
+		return regno(p) == FPREG;
+	case NAME:
+		return licmmem == 0;
+	case OREG:
+		return licmmem == 0 && regno(p) == FPREG;
+	case UMINUS:
+	case COMPL:
+	case SCONV:
+	case PCONV:
+		return licminv(p->n_left);
+	case PLUS:
+	case MINUS:
+	case MUL:
+	case AND:
+	case OR:
+	case ER:
+	case LS:
+	case RS:
+		return licminv(p->n_left) && licminv(p->n_right);
+	}
+	return 0;
+}
+
+static int
+licmnode(struct p2env *p2e, NODE *p, struct licm **hl)
+{
+	struct licm *h;
+	NODE *q;
+	int o, n;
+
+	if (licminv(p) && csecost(p) > 1) {
+		for (h = *hl; h; h = h->next)
+			if (csecmp(h->p, p))
+				break;
+		if (h == NULL) {
+			h = tmpalloc(sizeof(struct licm));
+			h->tnum = p2e->epp->ip_tmpnum++;
+			q = talloc();
+			*q = *p;
+			h->p = q;
+			h->next = *hl;
+			*hl = h;
+		} else if ((o = optype(p->n_op)) != LTYPE) {
+			if (o == BITYPE)
+				tfree(p->n_right);
+			tfree(p->n_left);
+		}
+		csetemp(p, h->tnum);
+		return 1;
+	}
+	switch (p->n_op) {
+	case ADDROF:
+	case XASM:
+	case GOTO:
+		return 0;
+	case ASSIGN:
+		/* never replace the destination itself */
+		n = 0;
+		if (p->n_left->n_op == UMUL)
+			n = licmnode(p2e, p->n_left->n_left, hl);
+		return n + licmnode(p2e, p->n_right, hl);
+	}
+	o = optype(p->n_op);
+	n = 0;
+	if (o != LTYPE)
+		n += licmnode(p2e, p->n_left, hl);
+	if (o == BITYPE)
+		n += licmnode(p2e, p->n_right, hl);
+	return n;
+}
+
+/*
+ * Find the temps assigned in the loop and whether it writes memory.
+ */
+static void
+licminit(struct p2env *p2e, struct loop *l)
+{
+	struct interpass *ip;
+	struct basicblock *bb;
+	int i;
+
+	licmtmin = p2e->ipp->ip_tmpnum;
+	licmtmax = p2e->epp->ip_tmpnum;
+	licmdefs = setalloc(licmtmax - licmtmin + 1);
+	licmmem = 0;
+	for (i = 1; i < p2e->bbinfo.size; i++) {
+		if (!TESTBIT(l->body, i))
+			continue;
+		bb = p2e->bbinfo.arr[i];
+		for (ip = bb->first; ; ip = DLIST_NEXT(ip, qelem)) {
+			if (ip->type == IP_NODE)
+				walkf(ip->ip_node, licmscan, 0);
+			if (ip == bb->last)
+				break;
+		}
+	}
+}
+
+static int
+licm(struct p2env *p2e, struct loop *l)
+{
+	struct interpass *ip, *at;
+	struct basicblock *bb;
+	struct licm *hl, *h, *rl;
+	int i, n;
+
+	if (mkpreheader(l, 0) == NULL)
+		return 0;
+	licminit(p2e, l);
+
+	hl = NULL;
+	n = 0;
+	for (i = 1; i < p2e->bbinfo.size; i++) {
+		if (!TESTBIT(l->body, i))
+			continue;
+		bb = p2e->bbinfo.arr[i];
+		for (ip = bb->first; ; ip = DLIST_NEXT(ip, qelem)) {
+			if (ip->type == IP_NODE)
+				n += licmnode(p2e, ip->ip_node, &hl);
+			if (ip == bb->last)
+				break;
+		}
+	}
+	if (n == 0)
+		return 0;
+
+	/* emit in the order found */
+	for (rl = NULL; hl; hl = h) {
+		h = hl->next;
+		hl->next = rl;
+		rl = hl;
+	}
+	at = mkpreheader(l, 1);
+	for (h = rl; h; h = h->next) {
+		ip = ipnode(mkbinode(ASSIGN,
+		    mktemp(h->tnum, h->p->n_type), h->p, h->p->n_type));
+		ip->lineno = at->lineno;
+		DLIST_INSERT_BEFORE(at, ip, qelem);
+	}
+	BDEBUG(("licm: loop at %d, %d expressions moved\n",
+	    l->header->dfnum, n));
+	return n;
+}
+
+/*
+ * Induction variable strength reduction.  A basic induction variable
+ * is a temp that the loop only changes by adding a constant to it,
+ * either directly or as j = i + c; i = j as left by the SSA pass.
+ * An address base + i*k with an invariant base is then kept in a temp
+ * of its own, set up in the preheader and stepped by c*k wherever i
+ * is.  If that temp is dereferenced only once it is stepped just before
+ * the use instead, so that the post-increment pass can fold the two.
+ * Last, if only tests against constants are left of i, the tests are
+ * done on the pointer instead and i is removed from the loop.
+ */
+#define	IVMAX	4	/* new temps per loop */
+
+struct ivdef {
+	struct ivdef *next;
+	struct interpass *ip;	/* statement that changes i */
+	struct interpass *add;	/* the j = i + c in front of it, or NULL */
+	struct basicblock *bb;
+	CONSZ c;
+};
+
+struct ivar {
+	struct ivar *next;
+	NODE *p;		/* base + i*k, computed in the preheader */
+	NODE *base;
+	int iv;			/* the basic variable i */
+	int tnum;
+	CONSZ k;
+	int nuse;
+	NODE *use, *up;		/* the last use and its parent */
+	struct interpass *useip;
+	struct basicblock *usebb;
+};
+
+static struct ivdef **ivdefs;
+static char *ivbad;
+static struct interpass *ivip;
+static struct basicblock *ivbb;
+static int *ivuses, *ivndef;
+static NODE **ivinit;
+
+/*
+ * Return 1 if p is t + c or t - c, with the constant in *c.
+ */
+static int
+ivstep(NODE *p, int t, CONSZ *c)
+{
+	NODE *r;
+
+	if (p->n_op != PLUS && p->n_op != MINUS)
+		return 0;
+	r = p->n_right;
+	if (p->n_left->n_op != TEMP || regno(p->n_left) != t ||
+	    r->n_op != ICON || r->n_name[0] != 0)
+		return 0;
+	*c = p->n_op == PLUS ? getlval(r) : -getlval(r);
+	return 1;
+}
+
+static void
+ivscan(NODE *p, void *arg)
+{
+	struct interpass *prev;
+	struct ivdef *d;
+	NODE *q;
+	int t;
+
+	if ((p->n_op != ASSIGN && p->n_op != XARG) ||
+	    p->n_left->n_op != TEMP)
+		return;
+	t = regno(p->n_left) - licmtmin;
+	if (t < 0 || regno(p->n_left) >= licmtmax)
+		return;
+	if (p != ivip->ip_node || p->n_op != ASSIGN ||
+	    szty(p->n_type) != 1) {
+		ivbad[t] = 1;
+		return;
+	}
+	d = tmpalloc(sizeof(struct ivdef));
+	d->ip = ivip;
+	d->bb = ivbb;
+	d->add = NULL;
+	q = p->n_right;
+	if (!ivstep(q, regno(p->n_left), &d->c)) {
+		prev = DLIST_PREV(ivip, qelem);
+		if (q->n_op != TEMP || ivip == ivbb->first ||
+		    prev->type != IP_NODE || prev->ip_node->n_op != ASSIGN ||
+		    prev->ip_node->n_left->n_op != TEMP ||
+		    regno(prev->ip_node->n_left) != regno(q) ||
+		    !ivstep(prev->ip_node->n_right, regno(p->n_left), &d->c)) {
+			ivbad[t] = 1;
+			return;
+		}
+		d->add = prev;
+	}
+	d->next = ivdefs[t];
+	ivdefs[t] = d;
+}
+
+static int
+isiv(NODE *p)
+{
+	int t;
+
+	if (p->n_op != TEMP || regno(p) < licmtmin || regno(p) >= licmtmax)
+		return 0;
+	t = regno(p) - licmtmin;
+	return ivdefs[t] != NULL && ivbad[t] == 0;
+}
+
+/*
+ * Return the temp if p is i, i << s or i * k, with the factor in *k.
+ */
+static int
+ivscaled(NODE *p, CONSZ *k)
+{
+	NODE *r;
+
+	*k = 1;
+	if (p->n_op == LS || p->n_op == MUL) {
+		r = p->n_right;
+		if (r->n_op != ICON || r->n_name[0] != 0 || getlval(r) <= 0)
+			return -1;
+		if (p->n_op == MUL)
+			*k = getlval(r);
+		else if (getlval(r) < SZINT)
+			*k = (CONSZ)1 << getlval(r);
+		else
+			return -1;
+		p = p->n_left;
+	}
+	return isiv(p) ? regno(p) : -1;
+}
+
+/*
+ * Return the induction variable if p is worth a temp of its own.
+ */
+static int
+ivmatch(NODE *p, CONSZ *k, NODE **bp)
+{
+	NODE *b;
+	int t;
+
+	if (szty(p->n_type) != 1 || OBJVOL(p))
+		return -1;
+	if (p->n_op == MUL) {
+		t = ivscaled(p, k);
+		return *k > 1 ? t : -1;
+	}
+	if (p->n_op != PLUS || !ISPTR(p->n_type))
+		return -1;
+	b = p->n_left;
+	if ((t = ivscaled(p->n_right, k)) < 0) {
+		b = p->n_right;
+		if ((t = ivscaled(p->n_left, k)) < 0)
+			return -1;
+	}
+	if (!licminv(b))
+		return -1;
+	*bp = b;
+	return t;
+}
+
+static void
+ivnode(struct p2env *p2e, NODE *p, NODE *up, struct ivar **il)
+{
+	struct ivar *v;
+	NODE *q, *b;
+	CONSZ k;
+	int o, t, n;
+
+	b = NULL;
+	k = 1;
+	if ((t = ivmatch(p, &k, &b)) >= 0) {
+		for (n = 0, v = *il; v; v = v->next, n++)
+			if (csecmp(v->p, p))
+				break;
+		if (v == NULL && n < IVMAX) {
+			v = tmpalloc(sizeof(struct ivar));
+			q = talloc();
+			*q = *p;
+			v->p = q;
+			v->base = b;
+			v->iv = t;
+			v->k = k;
+			v->tnum = p2e->epp->ip_tmpnum++;
+			v->nuse = 0;
+			v->next = *il;
+			*il = v;
+		} else if (v != NULL) {
+			tfree(p->n_left);
+			tfree(p->n_right);
+		}
+		if (v != NULL) {
+			csetemp(p, v->tnum);
+			v->nuse++;
+			v->use = p;
+			v->up = up;
+			v->useip = ivip;
+			v->usebb = ivbb;
+			return;
+		}
+	}
+	switch (p->n_op) {
+	case ADDROF:
+	case XASM:
+	case GOTO:
+		return;
+	case ASSIGN:
+		if (p->n_left->n_op == UMUL)
+			ivnode(p2e, p->n_left->n_left, p->n_left, il);
+		ivnode(p2e, p->n_right, p, il);
+		return;
+	}
+	o = optype(p->n_op);
+	if (o != LTYPE)
+		ivnode(p2e, p->n_left, p, il);
+	if (o == BITYPE)
+		ivnode(p2e, p->n_right, p, il);
+}
+
+static NODE *
+ivadd(int tnum, TWORD t, CONSZ c)
+{
+	return mkbinode(ASSIGN, mktemp(tnum, t), mkbinode(PLUS,
+	    mktemp(tnum, t), mklnode(ICON, c, 0, INT), t), t);
+}
+
+#ifdef AUTOINC
+/*
+ * Return 1 if ip comes before the change of i in the block.
+ */
+static int
+ivbefore(struct interpass *ip, struct ivdef *d)
+{
+	struct interpass *end = d->add ? d->add : d->ip;
+
+	for (; ip != end; ip = DLIST_NEXT(ip, qelem))
+		if (ip == d->bb->last)
+			return 0;
+	return 1;
+}
+#endif
+
+static void
+ivcount(NODE *p, void *arg)
+{
+	if (p->n_op != TEMP || regno(p) < licmtmin || regno(p) >= licmtmax)
+		return;
+	ivuses[regno(p) - licmtmin]++;
+}
+
+static void
+ivcntdef(NODE *p, void *arg)
+{
+	struct ivdef *d;
+	int t;
+
+	if ((p->n_op != ASSIGN && p->n_op != XARG) ||
+	    p->n_left->n_op != TEMP)
+		return;
+	t = regno(p->n_left) - licmtmin;
+	if (t < 0 || regno(p->n_left) >= licmtmax)
+		return;
+	ivuses[t]--;
+	ivndef[t]++;
+	for (d = ivdefs[t]; d; d = d->next)
+		if (d->ip->ip_node == p)
+			return;
+	ivinit[t] = p->n_right;
+}
+
+/*
+ * Start value of i if it is a known constant.
+ */
+static int
+ivstart(int t, CONSZ *v)
+{
+	NODE *p;
+
+	if (ivndef[t] != 2 || (p = ivinit[t]) == NULL)
+		return 0;
+	if (p->n_op == TEMP && regno(p) >= licmtmin &&
+	    regno(p) < licmtmax && ivndef[regno(p) - licmtmin] == 1)
+		p = ivinit[regno(p) - licmtmin];
+	if (p->n_op != ICON || p->n_name[0] != 0)
+		return 0;
+	*v = getlval(p);
+	return 1;
+}
+
+/*
+ * The value of base + i*k when i starts at v0.
+ */
+static NODE *
+ivfirst(struct ivar *v, CONSZ v0)
+{
+	TWORD t = v->p->n_type;
+	NODE *p, *b = v->base;
+	CONSZ off = v0 * v->k;
+
+	if (b == NULL)
+		return mklnode(ICON, off, 0, t);
+	if (b->n_op == ICON) {
+		p = tcopy(b);
+		setlval(p, getlval(p) + off);
+		p->n_type = t;
+		return p;
+	}
+	if (off == 0 && b->n_type == t)
+		return tcopy(b);
+	return mkbinode(PLUS, tcopy(b), mklnode(ICON, off, 0, INT), t);
+}
+
+static int
+ivrelop(int o)
+{
+	switch (o) {
+	case LT: return ULT;
+	case LE: return ULE;
+	case GT: return UGT;
+	case GE: return UGE;
+	case EQ:
+	case NE:
+	case ULT:
+	case ULE:
+	case UGT:
+	case UGE:
+		return o;
+	}
+	return 0;
+}
+
+#define	IVDEL	8
+
+/*
+ * 1 if block from can get back to itself inside the loop without
+ * passing through block skip.
+ */
+static int
+ivcycle(struct p2env *p2e, struct loop *l, struct basicblock *from,
+    struct basicblock *skip)
+{
+	struct basicblock *bb, **stk;
+	struct cfgnode *cn;
+	bittype *seen;
+	int sp;
+
+	if (from == skip)
+		return 0;
+	stk = tmpalloc(p2e->bbinfo.size * sizeof(struct basicblock *));
+	seen = setalloc(p2e->bbinfo.size);
+	sp = 0;
+	stk[sp++] = from;
+	while (sp > 0) {
+		SLIST_FOREACH(cn, &stk[--sp]->child, chld) {
+			bb = cn->bblock;
+			if (bb == from)
+				return 1;
+			if (bb == skip || bb->dfnum == 0 ||
+			    !TESTBIT(l->body, bb->dfnum) ||
+			    TESTBIT(seen, bb->dfnum))
+				continue;
+			BITSET(seen, bb->dfnum);
+			stk[sp++] = bb;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Test p on i ends block bb.  If it leaves the loop, and the step of
+ * i cannot run twice without passing it, set *bp so that i <= *bp
+ * everywhere in the loop after the first pass.
+ */
+static int
+ivexit(struct p2env *p2e, struct loop *l, struct basicblock *bb,
+    NODE *p, struct ivdef *d, CONSZ v0, CONSZ *bp)
+{
+	extern int negrel[];
+	struct basicblock *tb;
+	struct cfgnode *cn;
+	unsigned int lab;
+	CONSZ n;
+	int o, out;
+
+	/* new preheader labels are past labinfo and outside this loop */
+	lab = (unsigned int)getlval(p->n_right);
+	tb = NULL;
+	if (lab - p2e->labinfo.low < (unsigned int)p2e->labinfo.size &&
+	    (tb = p2e->labinfo.arr[lab - p2e->labinfo.low]) == NULL)
+		return 0;
+	out = 0;
+	SLIST_FOREACH(cn, &bb->child, chld)
+		if (cn->bblock->dfnum == 0 ||
+		    !TESTBIT(l->body, cn->bblock->dfnum))
+			out = 1;
+	o = p->n_left->n_op;
+	if (tb == NULL || tb->dfnum == 0 || !TESTBIT(l->body, tb->dfnum))
+		o = negrel[o - EQ];	/* jumps out, goes on if false */
+	else if (out == 0)
+		return 0;
+	if (ivcycle(p2e, l, d->bb, bb))
+		return 0;
+
+	/* i goes up by at most one between two passes of the test */
+	n = getlval(p->n_left->n_right);
+	switch (o) {
+	case LT:
+	case ULT:
+		break;
+	case LE:
+	case ULE:
+		n++;
+		break;
+	case NE:
+		if (v0 >= n)
+			return 0;
+		break;
+	default:
+		return 0;
+	}
+	*bp = n;
+	return 1;
+}
+
+/*
+ * Linear function test replacement.  i starts at a known value that
+ * is not negative and steps by one, and an exit test keeps it below a
+ * limit.  If base is an array that reaches base + limit*k, the pointer
+ * cannot wrap and comparing it unsigned to base + n*k is the same as
+ * comparing i to n.
+ */
+static int
+ivlftr(struct p2env *p2e, struct loop *l, struct ivar *v, CONSZ v0)
+{
+	struct interpass *ip, *del[IVDEL];
+	struct basicblock *bb, *dbb[IVDEL];
+	struct ivdef *d;
+	struct attr *ap;
+	NODE *p, *q, *b;
+	CONSZ off, max, lim, e;
+	int i, j, n, t, nt, ndel, cnt;
+
+	t = v->iv - licmtmin;
+	d = ivdefs[t];
+	b = v->base;
+	if (d->next != NULL || d->c != 1 || b == NULL || b->n_op != ICON ||
+	    (ap = attr_find(b->n_ap, ATTR_P2ARRAY)) == NULL ||
+	    !ISPTR(b->n_type) || v->k <= 0 || v0 < 0)
+		return 0;
+
+	/* what may be left of i: the step, the tests and dead copies */
+	ndel = 0;
+	del[ndel] = d->ip;
+	dbb[ndel++] = d->bb;
+	if (d->add != NULL) {
+		q = d->add->ip_node->n_left;
+		if (ivuses[regno(q) - licmtmin] != 1)
+			return 0;
+		del[ndel] = d->add;
+		dbb[ndel++] = d->bb;
+	}
+	cnt = 1;
+	nt = 0;
+	lim = -1;
+	max = v0 + 1;
+	for (i = 1; i < p2e->bbinfo.size; i++) {
+		if (!TESTBIT(l->body, i))
+			continue;
+		bb = p2e->bbinfo.arr[i];
+		for (ip = bb->first; ; ip = DLIST_NEXT(ip, qelem)) {
+			p = ip->type == IP_NODE ? ip->ip_node : NULL;
+			if (p && p->n_op == CBRANCH && ivrelop(p->n_left->n_op) &&
+			    (q = p->n_left)->n_left->n_op == TEMP &&
+			    regno(q->n_left) == v->iv &&
+			    q->n_right->n_op == ICON &&
+			    q->n_right->n_name[0] == 0 && getlval(q->n_right) >= 0 &&
+			    getlval(q->n_right) * v->k < (CONSZ)1 << (SZINT-1)) {
+				cnt++, nt++;
+				if (getlval(q->n_right) > max)
+					max = getlval(q->n_right);
+				if (ivexit(p2e, l, bb, p, d, v0, &e) &&
+				    (lim < 0 || e < lim))
+					lim = e;
+			} else if (p && p->n_op == ASSIGN &&
+			    p->n_left->n_op == TEMP && p->n_right->n_op == TEMP &&
+			    regno(p->n_right) == v->iv &&
+			    regno(p->n_left) >= licmtmin &&
+			    regno(p->n_left) < licmtmax &&
+			    ivuses[regno(p->n_left) - licmtmin] == 0) {
+				if (ndel == IVDEL)
+					return 0;
+				del[ndel] = ip;
+				dbb[ndel++] = bb;
+				cnt++;
+			}
+			if (ip == bb->last)
+				break;
+		}
+	}
+	if (nt == 0 || ivuses[t] != cnt || lim < 0)
+		return 0;
+
+	/* every pointer compared must stay inside the array */
+	if (lim > max)
+		max = lim;
+	if (getlval(b) < 0 || getlval(b) + max * v->k > ap->iarg(0))
+		return 0;
+
+	/* keep every block non-empty */
+	for (i = 0; i < ndel; i++) {
+		bb = dbb[i];
+		n = 0;
+		for (ip = bb->first; ; ip = DLIST_NEXT(ip, qelem)) {
+			for (j = 0; j < ndel; j++)
+				if (del[j] == ip)
+					break;
+			if (j == ndel)
+				n++;
+			if (ip == bb->last)
+				break;
+		}
+		if (n == 0)
+			return 0;
+	}
+
+	/* the limit as base + n*k */
+	for (i = 1; i < p2e->bbinfo.size; i++) {
+		if (!TESTBIT(l->body, i))
+			continue;
+		bb = p2e->bbinfo.arr[i];
+		for (ip = bb->first; ; ip = DLIST_NEXT(ip, qelem)) {
+			p = ip->type == IP_NODE ? ip->ip_node : NULL;
+			if (p && p->n_op == CBRANCH && ivrelop(p->n_left->n_op) &&
+			    (q = p->n_left)->n_left->n_op == TEMP &&
+			    regno(q->n_left) == v->iv) {
+				q->n_op = ivrelop(q->n_op);
+				q->n_left->n_type = v->p->n_type;
+				regno(q->n_left) = v->tnum;
+				off = getlval(q->n_right) * v->k;
+				nfree(q->n_right);
+				q->n_right = tcopy(b);
+				setlval(q->n_right, getlval(b) + off);
+				q->n_right->n_type = v->p->n_type;
+			}
+			if (ip == bb->last)
+				break;
+		}
+	}
+
+	for (i = 0; i < ndel; i++) {
+		bb = dbb[i];
+		ip = del[i];
+		if (ip == bb->first)
+			bb->first = DLIST_NEXT(ip, qelem);
+		if (ip == bb->last)
+			bb->last = DLIST_PREV(ip, qelem);
+		DLIST_REMOVE(ip, qelem);
+		tfree(ip->ip_node);
+	}
+	BDEBUG(("lftr: temp %d replaced by %d\n", v->iv, v->tnum));
+	return 1;
+}
+
+static int
+ivloop(struct p2env *p2e, struct loop *l)
+{
+	struct interpass *ip, *at, *nip;
+	struct basicblock *bb;
+	struct ivar *il, *v, *rl;
+	struct ivdef *d;
+	NODE *p;
+	CONSZ v0;
+	int i, n;
+
+	if (mkpreheader(l, 0) == NULL)
+		return 0;
+	licminit(p2e, l);
+	n = licmtmax - licmtmin;
+	ivdefs = tmpcalloc(n * sizeof(struct ivdef *));
+	ivbad = tmpcalloc(n);
+	for (i = 1; i < p2e->bbinfo.size; i++) {
+		if (!TESTBIT(l->body, i))
+			continue;
+		ivbb = bb = p2e->bbinfo.arr[i];
+		for (ip = bb->first; ; ip = DLIST_NEXT(ip, qelem)) {
+			ivip = ip;
+			if (ip->type == IP_NODE)
+				walkf(ip->ip_node, ivscan, 0);
+			if (ip == bb->last)
+				break;
+		}
+	}
+
+	il = NULL;
+	for (i = 1; i < p2e->bbinfo.size; i++) {
+		if (!TESTBIT(l->body, i))
+			continue;
+		ivbb = bb = p2e->bbinfo.arr[i];
+		for (ip = bb->first; ; ip = DLIST_NEXT(ip, qelem)) {
+			ivip = ip;
+			if (ip->type == IP_NODE)
+				ivnode(p2e, ip->ip_node, NULL, &il);
+			if (ip == bb->last)
+				break;
+		}
+	}
+	if (il == NULL)
+		return 0;
+
+	n = licmtmax - licmtmin;
+	ivuses = tmpcalloc(n * sizeof(int));
+	ivndef = tmpcalloc(n * sizeof(int));
+	ivinit = tmpcalloc(n * sizeof(NODE *));
+	DLIST_FOREACH(ip, &p2e->ipole, qelem) {
+		if (ip->type != IP_NODE)
+			continue;
+		walkf(ip->ip_node, ivcount, 0);
+		walkf(ip->ip_node, ivcntdef, 0);
+	}
+
+	for (rl = NULL; il; il = v) {
+		v = il->next;
+		il->next = rl;
+		rl = il;
+	}
+	at = mkpreheader(l, 1);
+	n = 0;
+	for (v = rl; v; v = v->next) {
+		TWORD t = v->p->n_type;
+
+		p = v->p;
+		if (ivstart(v->iv - licmtmin, &v0))
+			p = ivfirst(v, v0);
+		ip = ipnode(mkbinode(ASSIGN, mktemp(v->tnum, t), p, t));
+		ip->lineno = at->lineno;
+		DLIST_INSERT_BEFORE(at, ip, qelem);
+		n++;
+
+		d = ivdefs[v->iv - licmtmin];
+#ifdef AUTOINC
+		if (d->next == NULL && v->nuse == 1 && v->up != NULL &&
+		    v->up->n_op == UMUL && v->usebb == d->bb &&
+		    ivbefore(v->useip, d) &&
+		    d->c * v->k == aisize(v->up->n_type)) {
+			/* u = v; v = v + k; ... *u ... */
+			i = p2e->epp->ip_tmpnum++;
+			ip = ipnode(mkbinode(ASSIGN,
+			    mktemp(i, t), mktemp(v->tnum, t), t));
+			nip = ipnode(ivadd(v->tnum, t, d->c * v->k));
+			ip->lineno = nip->lineno = v->useip->lineno;
+			DLIST_INSERT_BEFORE(v->useip, ip, qelem);
+			DLIST_INSERT_BEFORE(v->useip, nip, qelem);
+			if (v->usebb->first == v->useip)
+				v->usebb->first = ip;
+			regno(v->use) = i;
+			continue;
+		}
+#endif
+		for (; d; d = d->next) {
+			ip = ipnode(ivadd(v->tnum, t, d->c * v->k));
+			ip->lineno = d->ip->lineno;
+			DLIST_INSERT_AFTER(d->ip, ip, qelem);
+			if (d->bb->last == d->ip)
+				d->bb->last = ip;
+		}
+	}
+
+	/* one test replacement per basic variable */
+	for (v = rl; v; v = v->next) {
+		for (il = rl; il != v; il = il->next)
+			if (il->iv == v->iv)
+				break;
+		if (il == v && ivstart(v->iv - licmtmin, &v0))
+			ivlftr(p2e, l, v, v0);
+	}
+	for (v = rl; v; v = v->next)
+		if (ivstart(v->iv - licmtmin, &v0))
+			tfree(v->p);
+	BDEBUG(("iv: loop at %d, %d new temps\n", l->header->dfnum, n));
+	return n;
+}
+
+/*
+ * Preheaders were added, redo the flow graph.
+ */
+static void
+loopredo(struct p2env *p2e)
+{
+	bblocks_build(p2e);
+	cfg_build(p2e);
+	dominators(p2e);
+	findloops(p2e);
+}
+
+static void
+loopopt(struct p2env *p2e)
+{
+	struct loop *l;
+	int n;
+
+	dominators(p2e);
+	findloops(p2e);
+	n = 0;
+	for (l = loops; l; l = l->next)
+		n += licm(p2e, l);
+	if (n)
+		loopredo(p2e);
+
+	n = 0;
+	for (l = loops; l; l = l->next)
+		n += ivloop(p2e, l);
+	if (n)
+		loopredo(p2e);
+}
+
+#define BITALLOC(ptr,all,sz) { \
+	int sz__s = BIT2BYTE(sz); ptr = all(sz__s); memset(ptr, 0, sz__s); }
+#define VALIDREG(p)	(p->n_op == REG && TESTBIT(validregs, regno(p)))
+#define XCHECK(x) if (x < 0 || x >= xbits) printf("x out of range %d\n", x)
+#define RUP(x) (((x)+NUMBITS-1)/NUMBITS)
+#define SETCOPY(t,f,i,n) for (i = 0; i < RUP(n); i++) t[i] = f[i]
+#define SETSET(t,f,i,n) for (i = 0; i < RUP(n); i++) t[i] |= f[i]
+#define SETCLEAR(t,f,i,n) for (i = 0; i < RUP(n); i++) t[i] &= ~f[i]
+#define SETCMP(v,t,f,i,n) for (i = 0; i < RUP(n); i++) \
+	if (t[i] != f[i]) v = 1
+
+static int xxx, xbits;
+/*
+ * Set/clear long term liveness for regs and temps.
+ */
+static void
+unionize(NODE *p, struct basicblock *bb, int suboff)
+{
+	int o, ty;
+
+	if ((o = p->n_op) == TEMP || VALIDREG(p)) {
+		int b = regno(p);
+		if (o == TEMP)
+			b = b - suboff + MAXREGS;
+XCHECK(b);
+		lsadd(bb->gen, b, xbits);
+	}
+	if (asgop(o)) {
+		if (p->n_left->n_op == TEMP || VALIDREG(p)) {
+			int b = regno(p->n_left);
+			if (p->n_left->n_op == TEMP)
+				b = b - suboff + MAXREGS;
+XCHECK(b);
+			lsdel(bb->gen, b);
+			lsadd(bb->killed, b, xbits);
+			unionize(p->n_right, bb, suboff);
+			return;
+		}
+	}
+	ty = optype(o);
+	if (ty != LTYPE)
+		unionize(p->n_left, bb, suboff);
+	if (ty == BITYPE)
+		unionize(p->n_right, bb, suboff);
+}
+
+/*
+ * Found an extended assembler node, so growel out gen/killed nodes.
+ */
+static void
+xasmionize(NODE *p, void *arg)
+{
+	struct basicblock *bb = arg;
+	int cw, b;
+
+	if (p->n_op == ICON && p->n_type == STRTY)
+		return; /* dummy end marker */
+
+	cw = xasmcode(p->n_name);
+	if (XASMVAL(cw) == 'n' || XASMVAL(cw) == 'm')
+		return; /* no flow analysis */
+	p = p->n_left;
+ 
+	if (XASMVAL(cw) == 'g' && p->n_op != TEMP && p->n_op != REG)
+		return; /* no flow analysis */
+
+	b = regno(p);
+#if 0
+	if (XASMVAL(cw) == 'r' && p->n_op == TEMP)
+		addnotspill(b);
+#endif
+#define MKTOFF(r)	((r) - xxx)
+	if (XASMISOUT(cw)) {
+		if (p->n_op == TEMP) {
+			lsdel(bb->gen, MKTOFF(b));
+			lsadd(bb->killed, MKTOFF(b), xbits);
+		} else if (p->n_op == REG) {
+			lsdel(bb->gen, b);
+			lsadd(bb->killed, b, xbits);	 
+		} else
+			uerror("bad xasm node type %d", p->n_op);
+	}
+	if (XASMISINP(cw)) {
+		if (p->n_op == TEMP) {
+			lsadd(bb->gen, MKTOFF(b), xbits);
+		} else if (p->n_op == REG) {
+			lsadd(bb->gen, b, xbits);
+		} else if (optype(p->n_op) != LTYPE) {
+			if (XASMVAL(cw) == 'r')
+				uerror("couldn't find available register");
+			else
+				uerror("bad xasm node type2");
+		}
+	}
+}
+
+/*
+ * Live sets.  A set starts out empty as a sorted list of members in
+ * lm[] and is turned into the bit vector lb[] when the list would
+ * take more space, so blocks with few live temporaries stay small.
+ */
+int
+lstest(struct lset *s, int b)
+{
+	int lo, hi, m;
+
+	if (s->ln < 0)
+		return TESTBIT(s->lb, b) != 0;
+	lo = 0, hi = s->ln;
+	while (lo < hi) {
+		m = (lo + hi) / 2;
+		if (s->lm[m] == b)
+			return 1;
+		if (s->lm[m] < b)
+			lo = m + 1;
+		else
+			hi = m;
+	}
+	return 0;
+}
+
+/*
+ * Add the n members in the sorted list m to s.  Returns the number of
+ * new members.
+ */
+static int
+lsmerge(struct lset *s, int *m, int n, int nbits)
+{
+	int i, j, k, c, *nm;
+
+	if (n == 0)
+		return 0;
+	c = 0;
+	if (s->ln < 0) {
+		for (i = 0; i < n; i++)
+			if (!TESTBIT(s->lb, m[i]))
+				BITSET(s->lb, m[i]), c++;
+		return c;
+	}
+	for (i = j = 0; i < n; i++) {
+		while (j < s->ln && s->lm[j] < m[i])
+			j++;
+		if (j == s->ln || s->lm[j] != m[i])
+			c++;
+	}
+	if (c == 0)
+		return 0;
+	if ((s->ln + c) * (int)sizeof(int) > BIT2BYTE(nbits)) {
+		BITALLOC(s->lb, tmpalloc, nbits);
+		for (i = 0; i < s->ln; i++)
+			BITSET(s->lb, s->lm[i]);
+		for (i = 0; i < n; i++)
+			BITSET(s->lb, m[i]);
+		s->ln = -1;
+		return c;
+	}
+	if (s->ln + c > s->lsz) {
+		s->lsz = (s->ln + c) * 2;
+		nm = tmpalloc(s->lsz * sizeof(int));
+		if (s->ln)
+			memcpy(nm, s->lm, s->ln * sizeof(int));
+		s->lm = nm;
+	}
+	/* merge from the end, in place */
+	i = n - 1, j = s->ln - 1, k = s->ln + c - 1;
+	while (i >= 0) {
+		if (j >= 0 && s->lm[j] > m[i])
+			s->lm[k--] = s->lm[j--];
+		else if (j >= 0 && s->lm[j] == m[i])
+			s->lm[k--] = s->lm[j--], i--;
+		else
+			s->lm[k--] = m[i--];
+	}
+	s->ln += c;
+	return c;
+}
+
+void
+lsadd(struct lset *s, int b, int nbits)
+{
+	(void)lsmerge(s, &b, 1, nbits);
+}
+
+void
+lsdel(struct lset *s, int b)
+{
+	int i;
+
+	if (s->ln < 0) {
+		BITCLEAR(s->lb, b);
+		return;
+	}
+	for (i = 0; i < s->ln; i++)
+		if (s->lm[i] == b)
+			break;
+	if (i == s->ln)
+		return;
+	for (s->ln--; i < s->ln; i++)
+		s->lm[i] = s->lm[i+1];
+}
+
+/*
+ * Copy s into the bit vector v.
+ */
+void
+lsbits(bittype *v, struct lset *s, int nbits)
+{
+	int i;
+
+	if (s->ln < 0) {
+		memcpy(v, s->lb, BIT2BYTE(nbits));
+		return;
+	}
+	memset(v, 0, BIT2BYTE(nbits));
+	for (i = 0; i < s->ln; i++)
+		BITSET(v, s->lm[i]);
+}
+
+/*
+ * Add the members of f to s.  Returns the number of new members.
+ */
+static int
+lsunion(struct lset *s, struct lset *f, int nbits, int *tmp)
+{
+	int i, n;
+
+	if (f->ln >= 0)
+		return lsmerge(s, f->lm, f->ln, nbits);
+	if (s->ln < 0) {
+		for (i = n = 0; i < nbits; i++) {
+			if (f->lb[i/NUMBITS] == 0) {
+				i |= NUMBITS-1;
+				continue;
+			}
+			if (TESTBIT(f->lb, i) && !TESTBIT(s->lb, i))
+				BITSET(s->lb, i), n++;
+		}
+		return n;
+	}
+	for (i = n = 0; i < nbits; i++)
+		if (TESTBIT(f->lb, i))
+			tmp[n++] = i;
+	return lsmerge(s, tmp, n, nbits);
+}
+
+/*
+ * in = in U (out - killed).  Returns the number of new members of in.
+ */
+static int
+lsflow(struct lset *in, struct lset *out, struct lset *killed, int nbits,
+    int *tmp)
+{
+	int i, b, n;
+
+	n = 0;
+	if (out->ln >= 0) {
+		for (i = 0; i < out->ln; i++)
+			if (!lstest(killed, out->lm[i]) &&
+			    !lstest(in, out->lm[i]))
+				tmp[n++] = out->lm[i];
+		return lsmerge(in, tmp, n, nbits);
+	}
+	for (b = 0; b < nbits; b++) {
+		if (out->lb[b/NUMBITS] == 0) {
+			b |= NUMBITS-1;
+			continue;
+		}
+		if (TESTBIT(out->lb, b) && !lstest(killed, b) &&
+		    !lstest(in, b))
+			tmp[n++] = b;
+	}
+	return lsmerge(in, tmp, n, nbits);
+}
+
+/*
+ * Solve the backward liveness equations
+ *	out[b] = out[b] U in[s] for each successor s
+ *	in[b] = gen[b] U (out[b] - killed[b])
+ * for the sets indexed by basic block number. Bits already set in out[]
+ * stay set (used for things live at exit).  in[] must be empty, it is
+ * started from gen[].  As out[] only grows, the new members of
+ * out[b] - killed[b] are just added to in[b].
+ *
+ * The blocks are put on a worklist in postorder of the CFG, so that a
+ * block usually is done after its successors, and only the predecessors
+ * of a block whose in set changed are visited again. Returns the number
+ * of block visits.
+ */
+int
+livesolve(struct p2env *p2e, struct lset *gen, struct lset *killed,
+    struct lset *in, struct lset *out, int nbits)
+{
+	struct basicblock *bb, **bbs, **stk;
+	struct cfgnode *cn, **cnstk;
+	int *npred, **pred, *queue, *onq, *tmp;
+	int nb, i, nq, qh, qt, sp, visits, changed;
+
+	if ((nb = p2e->nbblocks) == 0)
+		return 0;
+	tmp = tmpalloc((nbits+1) * sizeof(int));
+	bbs = tmpalloc(nb * sizeof(struct basicblock *));
+	npred = tmpalloc(nb * sizeof(int));
+	pred = tmpalloc(nb * sizeof(int *));
+	queue = tmpalloc(nb * sizeof(int));
+	onq = tmpalloc(nb * sizeof(int));
+	memset(bbs, 0, nb * sizeof(struct basicblock *));
+	memset(npred, 0, nb * sizeof(int));
+	memset(onq, 0, nb * sizeof(int));
+
+	/*
+	 * Predecessors, from the child lists.  dce() may have unlinked
+	 * blocks that are still someone's child; those are not walked.
+	 */
+	DLIST_FOREACH(bb, &p2e->bblocks, bbelem) {
+		bbs[bb->bbnum] = bb;
+		(void)lsunion(&in[bb->bbnum], &gen[bb->bbnum], nbits, tmp);
+	}
+	DLIST_FOREACH(bb, &p2e->bblocks, bbelem)
+		SLIST_FOREACH(cn, &bb->child, chld)
+			npred[cn->bblock->bbnum]++;
+	for (i = 0; i < nb; i++) {
+		pred[i] = tmpalloc((npred[i]+1) * sizeof(int));
+		npred[i] = 0;
+	}
+	DLIST_FOREACH(bb, &p2e->bblocks, bbelem)
+		SLIST_FOREACH(cn, &bb->child, chld) {
+			i = cn->bblock->bbnum;
+			pred[i][npred[i]++] = bb->bbnum;
+		}
+
+	/* depth-first walk from the entry, queue blocks in postorder */
+	stk = tmpalloc(nb * sizeof(struct basicblock *));
+	cnstk = tmpalloc(nb * sizeof(struct cfgnode *));
+	qt = sp = 0;
+	bb = DLIST_NEXT(&p2e->bblocks, bbelem);
+	if (bb != &p2e->bblocks) {
+		onq[bb->bbnum] = 1;
+		stk[sp] = bb, cnstk[sp++] = SLIST_FIRST(&bb->child);
+	}
+	while (sp > 0) {
+		bb = stk[sp-1];
+		if ((cn = cnstk[sp-1]) != NULL) {
+			cnstk[sp-1] = cn->chld.q_forw;
+			if (onq[cn->bblock->bbnum] == 0 &&
+			    bbs[cn->bblock->bbnum] == cn->bblock) {
+				onq[cn->bblock->bbnum] = 1;
+				stk[sp] = cn->bblock;
+				cnstk[sp++] = SLIST_FIRST(&cn->bblock->child);
+			}
+			continue;
+		}
+		queue[qt++] = bb->bbnum;
+		sp--;
+	}
+	/* unreachable blocks last */
+	DLIST_FOREACH_REVERSE(bb, &p2e->bblocks, bbelem)
+		if (onq[bb->bbnum] == 0) {
+			onq[bb->bbnum] = 1;
+			queue[qt++] = bb->bbnum;
+		}
+
+	/* queue is circular, a block is on it at most once */
+	nq = qt;
+	qh = 0;
+	qt %= nb;
+	visits = 0;
+	while (nq > 0) {
+		i = queue[qh];
+		qh = (qh + 1) % nb;
+		onq[i] = 0;
+		nq--;
+		visits++;
+		SLIST_FOREACH(cn, &bbs[i]->child, chld)
+			(void)lsunion(&out[i], &in[cn->bblock->bbnum], nbits, tmp);
+		changed = lsflow(&in[i], &out[i], &killed[i], nbits, tmp);
+		if (changed == 0)
+			continue;
+		for (sp = 0; sp < npred[i]; sp++) {
+			if (onq[pred[i][sp]] || bbs[pred[i][sp]] == NULL)
+				continue;
+			onq[pred[i][sp]] = 1;
+			queue[qt] = pred[i][sp];
+			qt = (qt + 1) % nb;
+			nq++;
+		}
+	}
+	return visits;
+}
+
+/*
+ * Do variable liveness analysis.  Only analyze the long-lived
+ * variables, and save the live-on-exit temporaries in a bit-field
+ * at the end of each basic block. This bit-field is later used
+ * when doing short-range liveness analysis in Build().
+ */
+void
+liveanal(struct p2env *p2e)
+{
+	struct basicblock *bb;
+	struct interpass *ip;
+	struct lset *gen, *killed, *in, *out;
+	int mintemp, n;
+
+	xbits = p2e->epp->ip_tmpnum - p2e->ipp->ip_tmpnum + MAXREGS;
+	mintemp = p2e->ipp->ip_tmpnum;
+
+	/* Just fetch space for the temporaries from heap */
+	n = p2e->nbblocks * sizeof(struct lset);
+	gen = tmpalloc(n), killed = tmpalloc(n);
+	in = tmpalloc(n), out = tmpalloc(n);
+	memset(gen, 0, n), memset(killed, 0, n);
+	memset(in, 0, n), memset(out, 0, n);
+	DLIST_FOREACH(bb, &p2e->bblocks, bbelem) {
+		bb->gen = &gen[bb->bbnum], bb->killed = &killed[bb->bbnum];
+		bb->in = &in[bb->bbnum], bb->out = &out[bb->bbnum];
+	}
+
+	xxx = mintemp;
+	/*
+	 * generate the gen-killed sets for all basic blocks.
+	 */
+	DLIST_FOREACH(bb, &p2e->bblocks, bbelem) {
+		for (ip = bb->last; ; ip = DLIST_PREV(ip, qelem)) {
+			/* gen/killed is 'p', this node is 'n' */
+			if (ip->type == IP_NODE) {
+				if (ip->ip_node->n_op == XASM)
+					flist(ip->ip_node->n_left,
+					    xasmionize, bb);
+				else
+					unionize(ip->ip_node, bb, mintemp);
+			}
+			if (ip == bb->first)
+				break;
+		}
+#ifdef PCC_DEBUG
+#define PRTRG(x) printf("%d ", x < MAXREGS ? x : x + p2e->ipp->ip_tmpnum-MAXREGS)
+		if (b2debug > 1) {
+			int i;
+
+			printf("basic block %d\ngen: ", bb->bbnum);
+			for (i = 0; i < xbits; i++)
+				if (lstest(bb->gen, i))
+					PRTRG(i);
+			printf("\nkilled: ");
+			for (i = 0; i < xbits; i++)
+				if (lstest(bb->killed, i))
+					PRTRG(i);
+			printf("\n");
+		}
+#endif
+	}
+	/* do liveness analysis on basic block level */
+	n = livesolve(p2e, gen, killed, in, out, xbits);
+	BDEBUG(("liveanal: %d blocks, %d visits\n", p2e->nbblocks, n));
 
 #ifdef PCC_DEBUG
 	DLIST_FOREACH(bb, &p2e->bblocks, bbelem) {
@@ -2266,11 +4047,11 @@ liveanal(struct p2env *p2e)
 
 			printf("all basic block %d\nin: ", bb->bbnum);
 			for (i = 0; i < xbits; i++)
-				if (TESTBIT(bb->in, i))
+				if (lstest(bb->in, i))
 					PRTRG(i);
 			printf("\nout: ");
 			for (i = 0; i < xbits; i++)
-				if (TESTBIT(bb->out, i))
+				if (lstest(bb->out, i))
 					PRTRG(i);
 			printf("\n");
 		}
@@ -135,6 +135,24 @@ typedef unsigned int bittype; /* XXX - for basicblock */
 #define	TLDOUBLE	0200000	/* long double; exceeds 16 bit */
 #define	TFTN		0400000	/* function pointer; exceeds 16 bit */
 
+/*
+ * Type classes.  ttype() gives the same answer for all types in a class.
+ * A class is a basic type, one of the two below, or any of these with
+ * TC_PTR added for pointers to it.  mkext merges the classes that no
+ * table entry tells apart into the tcmap[] that indexes qixoff[].
+ */
+#define	TC_PFTN		(BTMASK+1)	/* pointer to function */
+#define	TC_POINT	(BTMASK+2)	/* any other non-simple type */
+#define	TC_PTR		(BTMASK+3)
+#define	TC_ANY		(2*TC_PTR)	/* wildcard, matches every type */
+#define	NTCLASS		(TC_ANY+1)
+
+#ifndef MKEXT
+/* table entries for op o with left type class l and right class r */
+#define	TYCLASS(t)	tcmap[tclass(t)]
+#define	QINDEX(o, l, r)	(&qixpool[qixoff[((o)*NTCMAP+(l))*NTCMAP+(r)]])
+#endif
+
 /* reclamation cookies */
 #define RNULL		0	/* clobber result */
 #define RLEFT		01
@@ -146,6 +164,12 @@ typedef unsigned int bittype; /* XXX - for basicblock */
 #define RESCC		04000
 #define RNOP		010000	/* DANGER: can cause loops.. */
 
+/* condition codes the rule leaves set from its result compared with zero */
+#define	RCCEQ		020000	/* equal/not equal */
+#define	RCCGT		040000	/* signed greater/less */
+#define	RCCHI		0100000	/* unsigned higher/lower */
+#define	RCCZ		(RCCEQ|RCCGT|RCCHI)
+
 #ifdef	NEWNEED
 enum { cNREG = 1, cNTL, cNTR, cNSL, cNSR, cNL, cNR, cNOL, cNOR,
 	cNEVER, cNRES, cNTEMP, cNREW };
@@ -303,6 +327,13 @@ void lastcall(NODE *);
 void myreader(struct interpass *pole);
 int oregok(NODE *p, int sharp);
 void myormake(NODE *);
+#ifdef TAILCALL
+int tailcallok(NODE *);
+#endif
+#ifdef CCTRACK
+void ccset(NODE *, int, int);
+int cctest(NODE *);
+#endif
 int *livecall(NODE *);
 void prtreg(NODE *);
 char *prcook(int);
@@ -317,11 +348,15 @@ void mycanon(NODE *);
 void oreg2(NODE *p, void *);
 int shumul(NODE *p, int);
 NODE *deluseless(NODE *p);
+#ifdef AUTOINC
+int aisize(TWORD t);
+#endif
 int getlab2(void);
 int tshape(NODE *, int);
 void conput(FILE *, NODE *);
 int shtemp(NODE *p);
 int ttype(TWORD t, int tword);
+int tclass(TWORD t);
 void expand(NODE *, int, char *);
 void hopcode(int, int);
 void adrcon(CONSZ);
@@ -475,6 +510,25 @@ callop(int o)
 void emit(struct interpass *);
 void optimize(struct p2env *);
 
+/*
+ * Set of live registers and temporaries, by bit number.  A small set
+ * is a sorted list of its members, it becomes a bit vector when that
+ * takes less space.
+ */
+struct lset {
+	int ln;		/* members in lm, -1 if lb is used */
+	int lsz;	/* room in lm */
+	int *lm;
+	bittype *lb;
+};
+
+int lstest(struct lset *, int);
+void lsadd(struct lset *, int, int);
+void lsdel(struct lset *, int);
+void lsbits(bittype *, struct lset *, int);
+int livesolve(struct p2env *, struct lset *, struct lset *, struct lset *,
+    struct lset *, int);
+
 struct basicblock {
 	DLIST_ENTRY(basicblock) bbelem;
 	SLIST_HEAD(, cfgnode) parents;	/* CFG - parents to this node */
@@ -492,8 +546,9 @@ struct basicblock {
 	bittype *Aorig;
 	bittype *Aphi;
 	SLIST_HEAD(, phiinfo) phi;
+	int loopdepth;	/* number of loops the block is in */
 
-	bittype *gen, *killed, *in, *out;	/* Liveness analysis */
+	struct lset *gen, *killed, *in, *out;	/* Liveness analysis */
 
 	struct interpass *first; /* first element of basic block */
 	struct interpass *last;  /* last element of basic block */
@@ -571,6 +626,8 @@ extern struct p2env p2env;
 enum {
 	ATTR_P2_FIRST = ATTR_MI_MAX + 1,
 	ATTR_P2STRUCT,
+	ATTR_P2TAILCALL,
+	ATTR_P2ARRAY,
 #ifdef ATTR_P2_TARGET
 	ATTR_P2_TARGET,
 #endif
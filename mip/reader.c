@@ -320,21 +320,450 @@ deluseless(NODE *p)
 	return NULL;
 }
 
+#ifdef AUTOINC
+/*
+ * Post-increment addressing.
+ *
+ * Pass1 splits *p++ into
+ *
+ *	T1 = T0; T2 = T0 + n; ... *T1 ...
+ *
+ * where T2 is usually coalesced with T0 by the register allocator.
+ * If T1 is used only once, and after register allocation nothing
+ * between the increment and the dereference touches the register
+ * of T0, the copy and the add can be folded into the address,
+ * giving a post-increment OREG (AIPACK) for adrput() to print.
+ */
+static struct interpass **aicand;
+static int naicand;
+
+/*
+ * Size of an access that the target can post-increment past.
+ */
+int
+aisize(TWORD t)
+{
+	if (szty(t) != 1)
+		return 0;
+	if (t == CHAR || t == UCHAR)
+		return 1;
+	if (t == SHORT || t == USHORT)
+		return SZSHORT/SZCHAR;
+	if (t == INT || t == UNSIGNED)
+		return SZINT/SZCHAR;
+	if (ISPTR(t))
+		return SZPOINT(t)/SZCHAR;
+	return 0;
+}
+
+static void
+aicnt(NODE *p, void *arg)
+{
+	int *cnt = arg;
+
+	if (p->n_op == TEMP)
+		cnt[regno(p)]++;
+}
+
+/*
+ * Return 1 if p is ASSIGN(x, PLUS(a, ICON)), a being register/temp r.
+ * After register allocation x must also be a.
+ */
+static int
+aiisinc(NODE *p, int op, int r)
+{
+	NODE *q;
+
+	if (p->n_op != ASSIGN || p->n_left->n_op != op)
+		return 0;
+	if (op == REG && regno(p->n_left) != r)
+		return 0;
+	q = p->n_right;
+	if (q->n_op != PLUS || q->n_left->n_op != op ||
+	    regno(q->n_left) != r)
+		return 0;
+	q = q->n_right;
+	return q->n_op == ICON && q->n_name[0] == 0 && getlval(q) > 0;
+}
+
+/*
+ * Return 1 if ip is a copy T1 = T0 followed by an add to T0, with T1
+ * referenced only once more.
+ */
+static int
+aiiscand(struct interpass *ip, int *cnt)
+{
+	struct interpass *nip;
+	NODE *p;
+
+	if (ip->type != IP_NODE)
+		return 0;
+	p = ip->ip_node;
+	if (p->n_op != ASSIGN || p->n_left->n_op != TEMP ||
+	    p->n_right->n_op != TEMP || cnt[regno(p->n_left)] != 2)
+		return 0;
+	nip = DLIST_NEXT(ip, qelem);
+	return nip->type == IP_NODE &&
+	    aiisinc(nip->ip_node, TEMP, regno(p->n_right));
+}
+
+/*
+ * Before register allocation; remember the copies that may be folded.
+ */
+static void
+aifind(struct p2env *p2e)
+{
+	struct interpass *ip;
+	int *cnt, n;
+
+	naicand = 0;
+	n = p2e->epp->ip_tmpnum - p2e->ipp->ip_tmpnum;
+	if (n == 0)
+		return;
+	cnt = tmpcalloc(n * sizeof(int));
+	cnt -= p2e->ipp->ip_tmpnum;
+	DLIST_FOREACH(ip, &p2e->ipole, qelem)
+		if (ip->type == IP_NODE)
+			walkf(ip->ip_node, aicnt, cnt);
+
+	n = 0;
+	DLIST_FOREACH(ip, &p2e->ipole, qelem)
+		n += aiiscand(ip, cnt);
+	if (n == 0)
+		return;
+	aicand = tmpalloc(n * sizeof(struct interpass *));
+	DLIST_FOREACH(ip, &p2e->ipole, qelem)
+		if (aiiscand(ip, cnt))
+			aicand[naicand++] = ip;
+}
+
+/*
+ * Return 1 if register r is written or read by the instruction p.
+ */
+static int
+aiclash(NODE *p, int r)
+{
+	struct optab *q = &table[TBLIDX(p->n_su)];
+	int i, n, reg;
+
+	for (i = 0, n = ncnt(q->needs); i <= n; i++) {
+		reg = DECRA(p->n_reg, i);
+		if (reg < MAXREGS && interferes(reg, r))
+			return 1;
+	}
+#ifndef NEWNEED
+	if (q->needs & NSPECIAL) {
+		struct rspecial *rc;
+
+		for (rc = nspecial(q); rc->op; rc++)
+			if (interferes(rc->num, r))
+				return 1;
+	}
+#else
+	if (hasneed(q->needs, cNEVER) || hasneed(q->needs, cNRES))
+		return 1;
+#endif
+	return 0;
+}
+
+/*
+ * Check that nothing in p touches ra, and that rb is only used as
+ * one plain dereference.  The dereference is returned in *rp and
+ * the node using it in *up.  Returns 1 if the statement is unsafe.
+ */
+static int
+aiscan(NODE *p, NODE *parent, int ra, int rb, NODE **rp, NODE **up)
+{
+	int o = p->n_op;
+	int r;
+
+	if (callop(o) || o == XASM)
+		return 1;
+	if (o == UMUL && p->n_left->n_op == REG && regno(p->n_left) == rb) {
+		if (*rp != NULL || (TBLIDX(p->n_su) && aiclash(p, ra)))
+			return 1;
+		*rp = p, *up = parent;
+		return 0;
+	}
+	if (o == REG || o == OREG) {
+		r = regno(p);
+#ifdef R2REGS
+		if (o == OREG && R2TEST(r))
+			return 1;
+#endif
+		if (o == OREG && AITEST(r)) {
+			r = AIUPK(r);
+			if (interferes(r, ra) || interferes(r, rb))
+				return 1;
+		}
+		if (r < MAXREGS && interferes(r, ra))
+			return 1;
+		if (r < MAXREGS && interferes(r, rb)) {
+			if (o != OREG || r != rb || *rp != NULL ||
+			    getlval(p) != 0 || p->n_name[0] != 0)
+				return 1;
+			*rp = p, *up = parent;
+		}
+	}
+	if (TBLIDX(p->n_su) && aiclash(p, ra))
+		return 1;
+	if (optype(o) != LTYPE &&
+	    aiscan(p->n_left, p, ra, rb, rp, up))
+		return 1;
+	if (optype(o) == BITYPE &&
+	    aiscan(p->n_right, p, ra, rb, rp, up))
+		return 1;
+	return 0;
+}
+
+/*
+ * Return 1 if the instruction template s refers to side c exactly
+ * once, and only as a plain address.
+ */
+static int
+aitmpl(char *s, int c)
+{
+	int n = 0;
+
+	for (; *s; s++) {
+		if (*s == 'Z')
+			return 0;
+		if (*s >= 'A' && *s <= 'Z' && s[1] == c) {
+			if (*s != 'A')
+				return 0;
+			n++;
+		}
+	}
+	return n == 1;
+}
+
+/*
+ * Fold a candidate after register allocation, if still possible.
+ */
+static int
+aifold(struct interpass *ip)
+{
+	struct interpass *iip, *uip;
+	NODE *p, *rp, *up;
+	int ra, rb, n, c;
+
+	p = ip->ip_node;
+	if (p->n_op != ASSIGN || p->n_left->n_op != REG ||
+	    p->n_right->n_op != REG)
+		return 0;
+	rb = regno(p->n_left);
+	ra = regno(p->n_right);
+	iip = DLIST_NEXT(ip, qelem);
+	if (iip->type != IP_NODE || !aiisinc(iip->ip_node, REG, ra))
+		return 0;
+	n = (int)getlval(iip->ip_node->n_right->n_right);
+
+	/* Find the dereference, straight-line code only */
+	for (uip = DLIST_NEXT(iip, qelem); ; uip = DLIST_NEXT(uip, qelem)) {
+		if (uip->type != IP_NODE)
+			return 0;
+		p = uip->ip_node;
+		rp = up = NULL;
+		if (aiscan(p, NULL, ra, rb, &rp, &up))
+			return 0;
+		if (rp != NULL)
+			break;
+		if (p->n_op == CBRANCH || p->n_op == GOTO ||
+		    p->n_op == RETURN)
+			return 0;
+	}
+	if (aisize(rp->n_type) != n)
+		return 0;
+	if (TBLIDX(rp->n_su))
+		c = aitmpl(table[TBLIDX(rp->n_su)].cstring, 'L');
+	else if (up != NULL && TBLIDX(up->n_su))
+		c = aitmpl(table[TBLIDX(up->n_su)].cstring,
+		    up->n_left == rp ? 'L' : 'R');
+	else
+		c = 0;
+	if (c == 0)
+		return 0;
+
+	if (rp->n_op == UMUL) {
+		tfree(rp->n_left);
+		rp->n_op = OREG;
+		setlval(rp, 0);
+		rp->n_name = "";
+	}
+	rp->n_rval = AIPACK(ra);
+	DLIST_REMOVE(ip, qelem);
+	DLIST_REMOVE(iip, qelem);
+	tfree(ip->ip_node);
+	tfree(iip->ip_node);
+	return 1;
+}
+
+/*
+ * After register allocation; fold the remembered copies.
+ */
+static void
+aimake(struct p2env *p2e)
+{
+	struct interpass *ip, *nip, *pip;
+	int i;
+
+	if (naicand == 0)
+		return;
+	for (ip = DLIST_NEXT(&p2e->ipole, qelem); ip != &p2e->ipole; ip = nip) {
+		nip = DLIST_NEXT(ip, qelem);
+		if (ip->type != IP_NODE)
+			continue;
+		for (i = 0; i < naicand; i++)
+			if (aicand[i] == ip)
+				break;
+		if (i == naicand)
+			continue;
+		pip = DLIST_PREV(ip, qelem);
+		if (aifold(ip))
+			nip = DLIST_NEXT(pip, qelem);
+	}
+	naicand = 0;
+}
+#endif
+
+#ifdef TAILCALL
+/*
+ * Sibling calls.
+ *
+ * A direct call whose result, if any, is returned unchanged, and that
+ * is followed by nothing but a jump to the epilogue, may reuse the
+ * frame of the current function.  Such calls are marked with
+ * ATTR_P2TAILCALL and the target tears down the frame and jumps to the
+ * function instead of calling it.  Calls with stack arguments, or in
+ * functions that may leak a pointer into their frame, are left alone.
+ */
+static void
+tcaddr(NODE *p, void *arg)
+{
+	int *leak = arg;
+
+	if (p->n_op == ADDROF || (p->n_op == REG && regno(p) == FPREG))
+		*leak = 1;
+}
+
+static void
+tcargs(NODE *p, void *arg)
+{
+	int *stk = arg;
+
+	if (p->n_op == FUNARG || p->n_op == STARG)
+		*stk = 1;
+}
+
+/*
+ * Return the call in statement p if it may become a sibling call.
+ */
+static NODE *
+tccall(NODE *p)
+{
+	int stk = 0;
+
+	if (p->n_op == ASSIGN) {
+		if (p->n_left->n_op != REG ||
+		    regno(p->n_left) != RETREG(p->n_type) ||
+		    p->n_right->n_type != p->n_type)
+			return NULL;
+		p = p->n_right;
+	}
+	if (p->n_op != CALL && p->n_op != UCALL)
+		return NULL;
+	if (p->n_left->n_op != ICON || p->n_left->n_name[0] == 0)
+		return NULL;
+	if (p->n_op == CALL)
+		walkf(p->n_right, tcargs, &stk);
+	return stk ? NULL : p;
+}
+
+/*
+ * Labels and register moves to themselves (left over from coalescing
+ * the return value) emit nothing.  Count the labels in *lab.
+ */
+static int
+tcnop(struct interpass *ip, int *lab)
+{
+	NODE *p;
+
+	if (ip->type == IP_DEFLAB)
+		return ++*lab;
+	if (ip->type != IP_NODE)
+		return 0;
+	p = ip->ip_node;
+	return p->n_op == ASSIGN && p->n_left->n_op == REG &&
+	    p->n_right->n_op == REG && regno(p->n_left) == regno(p->n_right);
+}
+
+static void
+tailcall(struct p2env *p2e)
+{
+	struct interpass *ip, *nip;
+	NODE *p, *q;
+	int leak = 0, lab;
+
+	DLIST_FOREACH(ip, &p2e->ipole, qelem)
+		if (ip->type == IP_NODE)
+			walkf(ip->ip_node, tcaddr, &leak);
+	if (leak)
+		return;
+
+	DLIST_FOREACH(ip, &p2e->ipole, qelem) {
+		if (ip->type != IP_NODE || (p = tccall(ip->ip_node)) == NULL)
+			continue;
+		lab = 0;
+		for (nip = DLIST_NEXT(ip, qelem); tcnop(nip, &lab);
+		    nip = DLIST_NEXT(nip, qelem))
+			;
+		if (nip->type == IP_NODE && nip->ip_node->n_op == GOTO &&
+		    nip->ip_node->n_left->n_op == ICON &&
+		    getlval(nip->ip_node->n_left) == p2e->epp->ipp_ip.ip_lbl) {
+			if (!tailcallok(p))
+				continue;
+			if (lab == 0) {
+				/* never reached */
+				DLIST_REMOVE(nip, qelem);
+				tfree(nip->ip_node);
+			}
+		} else if (nip->type != IP_EPILOG || !tailcallok(p))
+			continue;
+		p->n_ap = attr_add(p->n_ap, attr_new(ATTR_P2TAILCALL, 0));
+		if ((q = ip->ip_node) != p) {
+			/* the call does not return here; drop the result move */
+			ip->ip_node = p;
+			nfree(q->n_left);
+			nfree(q);
+		}
+	}
+}
+#endif
+
 #ifdef PASS2
 
 #define	SKIPWS(p) while (*p == ' ') p++
 #define	SZIBUF 	256
-static int inpline;
-static char inpbuf[SZIBUF];
+static int inpline, inpsz;
+static char *inpbuf;
 static char *
 rdline(void)
 {
 	int l;
 
-	if (fgets(inpbuf, sizeof(inpbuf), stdin) == NULL)
+	if (inpbuf == NULL)
+		inpbuf = xmalloc(inpsz = SZIBUF);
+	if (fgets(inpbuf, inpsz, stdin) == NULL)
 		return NULL;
 	inpline++;
 	l = strlen(inpbuf);
+	while (inpbuf[l-1] != '\n' && l == inpsz-1) {
+		if ((inpbuf = realloc(inpbuf, inpsz *= 2)) == NULL)
+			cerror("out of memory!");
+		if (fgets(inpbuf+l, inpsz-l, stdin) == NULL)
+			break;
+		l += strlen(inpbuf+l);
+	}
 	if (inpbuf[0] < 33 || inpbuf[1] != ' ' || inpbuf[l-1] != '\n')
 		comperr("sync error in-line %d string '%s'", inpline, inpbuf);
 	inpbuf[l-1] = 0;
@@ -460,6 +889,250 @@ rdnode(char *s)
 	return p;
 }
 
+#ifdef TARGET_IPP_MEMBERS
+/*
+ * Read the target members line following a prolog or epilog.
+ */
+static void
+rdtarget(struct interpass_prolog *ipp, int c)
+{
+	char *p;
+
+	if ((p = rdline()) == NULL || *p != c)
+		comperr("target member error");
+	p += 2;
+	if (c == '(')
+		target_members_read_prolog(ipp);
+	else
+		target_members_read_epilog(ipp);
+	SKIPWS(p);
+	if (*p)
+		comperr("bad target members '%s' '%s'", p, inpbuf);
+}
+#endif
+
+/*
+ * Binary input, see IR_MAGIC in manifest.h.
+ */
+static int irbin, nirstr, irstrsz;
+static char **irstrs;
+
+static int
+irgetc(void)
+{
+	int c;
+
+	if ((c = getchar()) == EOF)
+		comperr("unexpected end of intermediate code");
+	return c;
+}
+
+static U_CONSZ
+irnum(void)
+{
+	U_CONSZ v = 0;
+	int c, sh = 0;
+
+	do {
+		c = irgetc();
+		v |= (U_CONSZ)(c & 0177) << sh;
+		sh += 7;
+	} while (c & 0200);
+	return v;
+}
+
+static CONSZ
+irsnum(void)
+{
+	U_CONSZ v = irnum();
+
+	return (CONSZ)(v >> 1) ^ -(CONSZ)(v & 1);
+}
+
+static char *
+irbytes(char *s, int l)
+{
+	if ((int)fread(s, 1, l, stdin) != l)
+		comperr("unexpected end of intermediate code");
+	s[l] = 0;
+	return s;
+}
+
+static char *
+irname(void)
+{
+	int i, l;
+
+	if ((i = irnum()) == 0) {
+		if (nirstr == irstrsz) {
+			irstrsz = irstrsz ? irstrsz * 2 : 256;
+			irstrs = realloc(irstrs, irstrsz * sizeof(char *));
+			if (irstrs == NULL)
+				cerror("out of memory!");
+		}
+		l = irnum();
+		return irstrs[nirstr++] = irbytes(xmalloc(l+1), l);
+	}
+	if (i > nirstr)
+		comperr("bad string index %d", i);
+	return irstrs[i-1];
+}
+
+/*
+ * Read a tree.  The node count is sent first, so the tree can be
+ * built from the prefix order nodes with a stack of unset pointers.
+ */
+static NODE *
+irnodes(void)
+{
+	struct attr *ap, **app;
+	NODE *p, *rv, ***stk;
+	int i, n, na, sp, ty;
+
+	n = irnum();
+	stk = tmpalloc((n+1) * sizeof(NODE **));
+	sp = 0;
+	stk[sp++] = &rv;
+	while (n-- > 0) {
+		if (sp == 0)
+			comperr("node count sync error");
+		p = talloc();
+		*stk[--sp] = p;
+		p->n_regw = NULL;
+		p->n_su = p->n_rval = 0;
+		setlval(p, 0);
+		p->n_name = "";
+		if ((p->n_op = irnum()) > MAXOP)
+			comperr("bad op %d", p->n_op);
+		p->n_type = irnum();
+		p->n_qual = irnum();
+		ty = optype(p->n_op);
+		if (ty == LTYPE)
+			setlval(p, irsnum());
+		if (ty != BITYPE && p->n_op != NAME && p->n_op != ICON)
+			p->n_rval = irsnum();
+		if (p->n_op == NAME || p->n_op == ICON ||
+		    p->n_op == XASM || p->n_op == XARG)
+			p->n_name = irname();
+		app = &p->n_ap;
+		for (na = irnum(); na > 0; na--) {
+			i = irnum();
+			ap = attr_new(i, irnum());
+			for (i = 0; i < ap->sz; i++)
+				ap->iarg(i) = irsnum();
+			*app = ap;
+			app = &ap->next;
+		}
+		*app = NULL;
+		if (ty == BITYPE)
+			stk[sp++] = &p->n_right;
+		if (ty != LTYPE)
+			stk[sp++] = &p->n_left;
+	}
+	if (sp != 0)
+		comperr("node count sync error");
+	return rv;
+}
+
+static void
+irrecord(int c)
+{
+	static int foo[] = { 0 };
+	struct interpass_prolog *ipp;
+	struct interpass *ip;
+	int i, n;
+
+	switch (c) {
+	case IR_LINE:
+		lineno = irnum();
+		return;
+
+	case IR_NODE:
+		ip = malloc(sizeof(struct interpass));
+		ip->type = IP_NODE;
+		ip->ip_node = irnodes();
+		break;
+
+	case IR_DEFLAB:
+		ip = malloc(sizeof(struct interpass));
+		ip->type = IP_DEFLAB;
+		ip->ip_lbl = irsnum();
+		break;
+
+	case IR_ASM:
+		n = irnum();
+		ip = malloc(sizeof(struct interpass));
+		ip->type = IP_ASM;
+		ip->ip_asm = irbytes(tmpalloc(n+1), n);
+		break;
+
+	case IR_PROLOG:
+		ipp = malloc(sizeof(struct interpass_prolog));
+		ip = (void *)ipp;
+		ip->type = IP_PROLOG;
+		ipp->ipp_type = irnum();
+		ipp->ipp_vis = irsnum();
+		ip->ip_lbl = irsnum();
+		ipp->ip_tmpnum = irsnum();
+		ipp->ip_lblnum = irsnum();
+		ipp->ipp_name = irname();
+		ipp->ipp_autos = -1;
+		ipp->ip_labels = foo;
+#ifdef TARGET_IPP_MEMBERS
+		rdtarget(ipp, '(');
+#endif
+		break;
+
+	case IR_EPILOG:
+		ipp = malloc(sizeof(struct interpass_prolog));
+		ip = (void *)ipp;
+		ip->type = IP_EPILOG;
+		ipp->ipp_autos = irsnum();
+		ip->ip_lbl = irsnum();
+		ipp->ip_tmpnum = irsnum();
+		ipp->ip_lblnum = irsnum();
+		ipp->ipp_name = irname();
+		if ((n = irnum()) > 0) {
+			ipp->ip_labels = tmpalloc(sizeof(int)*(n+1));
+			for (i = 0; i < n; i++)
+				ipp->ip_labels[i] = irsnum();
+			ipp->ip_labels[n] = 0;
+		} else
+			ipp->ip_labels = foo;
+#ifdef TARGET_IPP_MEMBERS
+		rdtarget(ipp, ')');
+#endif
+		break;
+
+	default:
+		comperr("bad intermediate code record %d", c);
+	}
+	pass2_compile(ip);
+}
+
+/*
+ * Check for the binary header, otherwise the input is text.
+ */
+static void
+irheader(void)
+{
+	char *m = IR_MAGIC;
+	int c;
+
+	if ((c = getchar()) != *m) {
+		if (c != EOF)
+			ungetc(c, stdin);
+		return;
+	}
+	for (m++; *m; m++)
+		if (getchar() != *m)
+			comperr("bad intermediate code header");
+	if ((c = irnum()) != IR_VERSION)
+		comperr("intermediate code version %d, expected %d",
+		    c, IR_VERSION);
+	irbin = 1;
+}
+
 /*
  * Read everything from pass1.
  */
@@ -469,10 +1142,23 @@ mainp2()
 	static int foo[] = { 0 };
 	struct interpass_prolog *ipp;
 	struct interpass *ip;
-	char nam[SZIBUF], *p, *b;
+	char *p, *b;
 	extern char *ftitle;
+	int c;
 
-	while ((p = rdline()) != NULL) {
+	irheader();
+	for (;;) {
+		if (irbin) {
+			if ((c = getchar()) == EOF)
+				break;
+			if (c & 0200) {
+				irrecord(c);
+				continue;
+			}
+			ungetc(c, stdin);
+		}
+		if ((p = rdline()) == NULL)
+			break;
 		b = p++;
 		p++;
 
@@ -503,20 +1189,16 @@ mainp2()
 			ipp = malloc(sizeof(struct interpass_prolog));
 			ip = (void *)ipp;
 			ip->type = IP_PROLOG;
-			sscanf(p, "%d %d %d %d %d %s", &ipp->ipp_type,
-			    &ipp->ipp_vis, &ip->ip_lbl, &ipp->ip_tmpnum,
-			    &ipp->ip_lblnum, nam);
-			ipp->ipp_name = xstrdup(nam);
+			ipp->ipp_type = rdint(&p);
+			ipp->ipp_vis = rdint(&p);
+			ip->ip_lbl = rdint(&p);
+			ipp->ip_tmpnum = rdint(&p);
+			ipp->ip_lblnum = rdint(&p);
+			ipp->ipp_name = xstrdup(rdstr(&p));
 			ipp->ipp_autos = -1;
 			ipp->ip_labels = foo;
 #ifdef TARGET_IPP_MEMBERS
-			if (*(p = rdline()) != '(')
-				comperr("target member error");
-			p += 2;
-			target_members_read_prolog(ipp);
-			SKIPWS(p);
-			if (*p)
-				comperr("bad prolog '%s' '%s'", p, inpbuf);
+			rdtarget(ipp, '(');
 #endif
 			pass2_compile((struct interpass *)ipp);
 			break;
@@ -545,13 +1227,7 @@ mainp2()
 			if (*p)
 				comperr("bad epilog '%s' '%s'", p, inpbuf);
 #ifdef TARGET_IPP_MEMBERS
-			if (*(p = rdline()) != ')')
-				comperr("target epi member error");
-			p += 2;
-			target_members_read_epilog(ipp);
-			SKIPWS(p);
-			if (*p)
-				comperr("bad epilog2 '%s' '%s'", p, inpbuf);
+			rdtarget(ipp, ')');
 #endif
 			pass2_compile((struct interpass *)ipp);
 			break;
@@ -664,13 +1340,26 @@ pass2_compile(struct interpass *ip)
 	fixxasm(p2e); /* setup for extended asm */
 
 	optimize(p2e);
+#ifdef AUTOINC
+	if (xtemps)
+		aifind(p2e);
+#endif
 	ngenregs(p2e);
+#ifdef AUTOINC
+	if (xtemps)
+		aimake(p2e);
+#endif
+#ifdef TAILCALL
+	if (xtailcall)
+		tailcall(p2e);
+#endif
 
 	if (xtemps && xdeljumps)
 		deljumps(p2e);
 
 	DLIST_FOREACH(ip, &p2e->ipole, qelem)
 		emit(ip);
+	nodereset();
 }
 
 void
@@ -715,6 +1404,9 @@ emit(struct interpass *ip)
 			gencode(p->n_left, INREGS);
 			break;
 		case XASM:
+#ifdef CCTRACK
+			ccset(NULL, 0, 0);
+#endif
 			genxasm(p);
 			break;
 		default:
@@ -735,6 +1427,9 @@ emit(struct interpass *ip)
 		deflab(ip->ip_lbl);
 		break;
 	case IP_ASM:
+#ifdef CCTRACK
+		ccset(NULL, 0, 0);
+#endif
 		printf("%s\n", ip->ip_asm);
 		break;
 	default:
@@ -1226,6 +1921,15 @@ gencode(NODE *p, int cookie)
 
 	canon(p);
 
+#ifdef CCTRACK
+	if (cctest(p)) {
+		/* status is still set from the value compared */
+		CDEBUG(("gencode(%p) compare nothing\n", p));
+		rewrite(p, q->rewrite, cookie);
+		return;
+	}
+#endif
+
 #ifdef NEWNEED
 	if (q->needs) {
 		char *w;
@@ -1304,6 +2008,9 @@ gencode(NODE *p, int cookie)
 		CDEBUG(("gencode(%p) RESC1 retreg\n", p));
 		rmove(DECRA(p->n_reg, 1), DECRA(p->n_reg, 0), p->n_type);
 	}
+#ifdef CCTRACK
+	ccset(p, cookie, q->rewrite);
+#endif
 #if 0
 		/* XXX - kolla upp det h{r */
 	   else if (p->n_op == ASSIGN) {
@@ -84,8 +84,10 @@
  *
  * The "live" set used during graph building is represented by a bitset.
  *
- * Interference edges are represented by struct AdjSet, hashed and linked
- * from index into the edgehash array.
+ * Interference edges are kept in a triangular bit matrix indexed by the
+ * node numbers when the function is small enough (ADJMATMAX nodes), else
+ * represented by struct AdjSet, hashed and linked from index into the
+ * edgehash array.
  *
  * A mapping from each node to the moves it is assiciated with is 
  * maintained by an array moveList which for each node number has a linked
@@ -156,6 +158,12 @@ int ntsz, stktemp;
 REGW *ablock;
 
 static int tempmin, tempmax, basetemp, xbits;
+/*
+ * Spill costs for the long-lived temporaries, and the value of those
+ * that can be recomputed where used instead of stored on the stack.
+ */
+static int *spcost, *spdefs, spweight;
+static NODE **remat;
 /*
  * nsavregs is an array that matches the permregs array.
  * Each entry in the array may have the values:
@@ -640,12 +648,83 @@ struct AdjSet {
 	REGW *u, *v;
 } *edgehash[HASHSZ];
 
+#define	ADJMATMAX	4096	/* max nodes for the bit matrix, 1MB */
+static bittype *adjmat;
+static int adjnodes;
+#ifdef PCC_DEBUG
+static int nedges, nprobes, maxprobe;
+#endif
+
+/*
+ * Nodes are numbered as the live set; precolored registers first,
+ * then the temporaries and last the short-lived nodes from nsucomp().
+ */
+static int
+adjnum(REGW *w)
+{
+	int n = ASGNUM(w);
+
+	n = n < MAXREGS ? n : n - tempmin + MAXREGS;
+#ifdef PCC_DEBUG
+	if (n < 0 || n >= adjnodes)
+		comperr("adjnum: node %d outside 0-%d", n, adjnodes);
+#endif
+	return n;
+}
+
+/* Index of the u-v pair in the matrix */
+static int
+adjbit(REGW *u, REGW *v)
+{
+	int a = adjnum(u), b = adjnum(v);
+
+	if (a < b)
+		return b * (b - 1) / 2 + a;
+	return a * (a - 1) / 2 + b;
+}
+
+/*
+ * Set up an empty interference graph once all nodes are numbered.
+ */
+static void
+adjinit(void)
+{
+	adjnodes = MAXREGS + nodnum - tempmin;
+	RDEBUGX(nedges = nprobes = maxprobe = 0);
+	memset(edgehash, 0, sizeof(edgehash));
+	adjmat = NULL;
+	if (adjnodes <= ADJMATMAX)
+		BITALLOC(adjmat, tmpalloc, adjnodes * (adjnodes - 1) / 2);
+}
+
+/*
+ * dce() redoes nsucomp() on the statements it changes, so there may
+ * be more short-lived nodes than adjinit() made room for.  The matrix is
+ * triangular; the old bits stay where they are in a larger one.
+ */
+static void
+adjgrow(void)
+{
+	bittype *m;
+	int n = MAXREGS + nodnum - tempmin;
+
+	if (n <= adjnodes)
+		return;
+	if (adjmat != NULL) {
+		BITALLOC(m, tmpalloc, n * (n - 1) / 2);
+		memcpy(m, adjmat, BIT2BYTE(adjnodes * (adjnodes - 1) / 2));
+		adjmat = m;
+	}
+	adjnodes = n;
+}
+
 /* Check if a node pair is adjacent */
 static int
 adjSet(REGW *u, REGW *v)
 {
 	struct AdjSet *w;
 	REGW *t;
+	int x;
 
 	if (ONLIST(u) == &precolored) {
 		ADJL *a = ADJLIST(v);
@@ -662,31 +741,52 @@ adjSet(REGW *u, REGW *v)
 		}
 	}
 
+	if (adjmat != NULL) {
+		x = adjbit(u, v);
+		return TESTBIT(adjmat, x) != 0;
+	}
+
 	w = edgehash[(u->nodnum+v->nodnum)& (HASHSZ-1)];
 
-	for (; w; w = w->next) {
+	for (x = 0; w; w = w->next, x++) {
 		if ((u == w->u && v == w->v) || (u == w->v && v == w->u))
-			return 1;
+			break;
 	}
-	return 0;
+	RDEBUGX(nprobes += x);
+	RDEBUGX(if (x > maxprobe) maxprobe = x);
+	return w != NULL;
 }
 
-/* Add a pair to adjset.  No check for dups */
+/* Add a pair to adjset.  Returns 1 if already there */
 static int
 adjSetadd(REGW *u, REGW *v)
 {
 	struct AdjSet *w;
-	int x;
+	int x, n;
+
+	if (adjmat != NULL) {
+		x = adjbit(u, v);
+		if (TESTBIT(adjmat, x))
+			return 1;
+		BITSET(adjmat, x);
+		RDEBUGX(nedges++);
+		return 0;
+	}
 
 	x = (u->nodnum+v->nodnum)& (HASHSZ-1);
-	for (w = edgehash[x]; w; w = w->next)
+	for (n = 0, w = edgehash[x]; w; w = w->next, n++)
 		if ((u == w->u && v == w->v) || (u == w->v && v == w->u))
-			return 1;
+			break;
+	RDEBUGX(nprobes += n);
+	RDEBUGX(if (n > maxprobe) maxprobe = n);
+	if (w != NULL)
+		return 1;
 
 	w = tmpalloc(sizeof(struct AdjSet));
 	w->u = u, w->v = v;
 	w->next = edgehash[x];
 	edgehash[x] = w;
+	RDEBUGX(nedges++);
 	return 0;
 }
 
@@ -1341,7 +1441,7 @@ insnwalk(NODE *p)
 	}
 }
 
-static bittype **gen, **killed, **in, **out;
+static struct lset *gen, *killed, *in, *out;
 
 struct notspill {
 	SLIST_ENTRY(notspill) link;
@@ -1407,19 +1507,19 @@ xasmionize(NODE *p, void *arg)
 #define	MKTOFF(r)	((r) - tempmin + MAXREGS)
 	if (XASMISOUT(cw)) {
 		if (p->n_op == TEMP) {
-			BITCLEAR(gen[bb], MKTOFF(b));
-			BITSET(killed[bb], MKTOFF(b));
+			lsdel(&gen[bb], MKTOFF(b));
+			lsadd(&killed[bb], MKTOFF(b), xbits);
 		} else if (p->n_op == REG) {
-			BITCLEAR(gen[bb], b);
-			BITSET(killed[bb], b);
+			lsdel(&gen[bb], b);
+			lsadd(&killed[bb], b, xbits);
 		} else
 			uerror("bad xasm node type %d", p->n_op);
 	}
 	if (XASMISINP(cw)) {
 		if (p->n_op == TEMP) {
-			BITSET(gen[bb], MKTOFF(b));
+			lsadd(&gen[bb], MKTOFF(b), xbits);
 		} else if (p->n_op == REG) {
-			BITSET(gen[bb], b);
+			lsadd(&gen[bb], b, xbits);
 		} else if (optype(p->n_op) != LTYPE) {
 			if (XASMVAL(cw) == 'r')
 				uerror("couldn't find available register");
@@ -1522,7 +1622,7 @@ dce(struct p2env *p2e)
 	struct interpass *ip;
 	NODE *p;
 	bittype *lvar;
-	int i, bbnum, fix = 0;
+	int bbnum, fix = 0;
 
 #ifdef mach_vax
 	return 0;	/* XXX may need to recalc tree structure */
@@ -1542,7 +1642,7 @@ dce(struct p2env *p2e)
 		bbnum = bb->bbnum;
 		BBDEBUG(("DCE bblock %d, start %p last %p\n",
 		    bbnum, bb->first, bb->last));
-		SETCOPY(lvar, out[bbnum], i, xbits);
+		lsbits(lvar, &out[bbnum], xbits);
 		for (ip = bb->last; ; ip = DLIST_PREV(ip, qelem)) {
 			if (ip->type == IP_NODE && deldead(ip->ip_node, lvar)) {
 				if ((p = deluseless(ip->ip_node)) == NULL) {
@@ -1600,6 +1700,7 @@ dce(struct p2env *p2e)
 		}
 	}
 	BDEBUG(("DCE fix %d\n", fix));
+	adjgrow();
 	return fix;
 }
 
@@ -1614,34 +1715,34 @@ unionize(NODE *p, int bb)
 	if ((o = p->n_op) == TEMP) {
 #ifdef notyet
 		for (i = 0; i < szty(p->n_type); i++) {
-			BITSET(gen[bb], (regno(p) - tempmin+i+MAXREGS));
+			lsadd(&gen[bb], (regno(p) - tempmin+i+MAXREGS), xbits);
 		}
 #else
 		i = 0;
-		BITSET(gen[bb], (regno(p) - tempmin+i+MAXREGS));
+		lsadd(&gen[bb], (regno(p) - tempmin+i+MAXREGS), xbits);
 #endif
 	} else if (VALIDREG(p)) {
-		BITSET(gen[bb], regno(p));
+		lsadd(&gen[bb], regno(p), xbits);
 	}
 	if (asgop(o)) {
 		if (p->n_left->n_op == TEMP) {
 			int b = regno(p->n_left) - tempmin+MAXREGS;
 #ifdef notyet
 			for (i = 0; i < szty(p->n_type); i++) {
-				BITCLEAR(gen[bb], (b+i));
-				BITSET(killed[bb], (b+i));
+				lsdel(&gen[bb], (b+i));
+				lsadd(&killed[bb], (b+i), xbits);
 			}
 #else
 			i = 0;
-			BITCLEAR(gen[bb], (b+i));
-			BITSET(killed[bb], (b+i));
+			lsdel(&gen[bb], (b+i));
+			lsadd(&killed[bb], (b+i), xbits);
 #endif
 			unionize(p->n_right, bb);
 			return;
 		} else if (VALIDREG(p->n_left)) {
 			int b = regno(p->n_left);
-			BITCLEAR(gen[bb], b);
-			BITSET(killed[bb], b);
+			lsdel(&gen[bb], b);
+			lsadd(&killed[bb], b, xbits);
 			unionize(p->n_right, bb);
 			return;
 		}
@@ -1683,7 +1784,6 @@ LivenessAnalysis(struct p2env *p2e)
 			if (ip == bb->first)
 				break;
 		}
-		memcpy(in[bbnum], gen[bbnum], BIT2BYTE(xbits));
 #ifdef PCC_DEBUG
 #define	PRTRG(x) printf("%d ", x < MAXREGS ? x : x + tempmin-MAXREGS)
 		if (r2debug) {
@@ -1691,11 +1791,11 @@ LivenessAnalysis(struct p2env *p2e)
 
 			printf("basic block %d\ngen: ", bbnum);
 			for (i = 0; i < xbits; i++)
-				if (TESTBIT(gen[bbnum], i))
+				if (lstest(&gen[bbnum], i))
 					PRTRG(i);
 			printf("\nkilled: ");
 			for (i = 0; i < xbits; i++)
-				if (TESTBIT(killed[bbnum], i))
+				if (lstest(&killed[bbnum], i))
 					PRTRG(i);
 			printf("\n");
 		}
@@ -1714,8 +1814,7 @@ Build(struct p2env *p2e)
 	struct basicblock bbfake;
 	struct interpass *ip;
 	struct basicblock *bb;
-	bittype *saved;
-	int i, j, again;
+	int i, j, n;
 
 	if (xtemps == 0) {
 		/*
@@ -1733,27 +1832,28 @@ Build(struct p2env *p2e)
 	}
 
 	/* Just fetch space for the temporaries from stack */
-	gen = tmpalloc(p2e->nbblocks*sizeof(bittype*));
-	killed = tmpalloc(p2e->nbblocks*sizeof(bittype*));
-	in = tmpalloc(p2e->nbblocks*sizeof(bittype*));
-	out = tmpalloc(p2e->nbblocks*sizeof(bittype*));
-	for (i = 0; i < p2e->nbblocks; i++) {
-		BITALLOC(gen[i],tmpalloc,xbits);
-		BITALLOC(killed[i],tmpalloc,xbits);
-		BITALLOC(in[i],tmpalloc,xbits);
-		BITALLOC(out[i],tmpalloc,xbits);
-	}
-	BITALLOC(saved,tmpalloc,xbits);
-
+	n = p2e->nbblocks * sizeof(struct lset);
+	gen = tmpalloc(n);
+	killed = tmpalloc(n);
+	in = tmpalloc(n);
+	out = tmpalloc(n);
 	SLIST_INIT(&nothead);
 livagain:
+	/*
+	 * The sets from liveanal() cannot be used here; instruction
+	 * selection and spilling have rewritten the trees since.
+	 */
+	memset(gen, 0, n);
+	memset(killed, 0, n);
+	memset(in, 0, n);
+	memset(out, 0, n);
 	LivenessAnalysis(p2e);
 
 	/* register variable temporaries are live */
 	for (i = 0; i < NPERMREG-1; i++) {
 		if (nsavregs[i])
 			continue;
-		BITSET(out[p2e->nbblocks-1], (i+MAXREGS));
+		lsadd(&out[p2e->nbblocks-1], (i+MAXREGS), xbits);
 		for (j = i+1; j < NPERMREG-1; j++) {
 			if (nsavregs[j])
 				continue;
@@ -1762,35 +1862,19 @@ livagain:
 	}
 
 	/* do liveness analysis on basic block level */
-	do {
-		struct cfgnode *cn;
-		again = 0;
-		/* XXX - loop should be in reversed execution-order */
-		DLIST_FOREACH_REVERSE(bb, &p2e->bblocks, bbelem) {
-			i = bb->bbnum;
-			SETCOPY(saved, out[i], j, xbits);
-			SLIST_FOREACH(cn, &bb->child, chld) {
-				SETSET(out[i], in[cn->bblock->bbnum], j, xbits);
-			}
-			SETCMP(again, saved, out[i], j, xbits);
-			SETCOPY(saved, in[i], j, xbits);
-			SETCOPY(in[i], out[i], j, xbits);
-			SETCLEAR(in[i], killed[i], j, xbits);
-			SETSET(in[i], gen[i], j, xbits);
-			SETCMP(again, saved, in[i], j, xbits);
-		}
-	} while (again);
+	i = livesolve(p2e, gen, killed, in, out, xbits);
+	RDEBUG(("Build: %d blocks, %d visits\n", p2e->nbblocks, i));
 
 #ifdef PCC_DEBUG
 	if (r2debug) {
 		DLIST_FOREACH(bb, &p2e->bblocks, bbelem) {
 			printf("basic block %d\nin: ", bb->bbnum);
 			for (i = 0; i < xbits; i++)
-				if (TESTBIT(in[bb->bbnum], i))
+				if (lstest(&in[bb->bbnum], i))
 					PRTRG(i);
 			printf("\nout: ");
 			for (i = 0; i < xbits; i++)
-				if (TESTBIT(out[bb->bbnum], i))
+				if (lstest(&out[bb->bbnum], i))
 					PRTRG(i);
 			printf("\n");
 		}
@@ -1805,25 +1889,14 @@ livagain:
 		 *
 		 * This should recalculate the basic block structure.
 		 */
-		if (dce(p2e)) {
-			/* Clear bitfields */
-			for (i = 0; i < p2e->nbblocks; i++) {
-				SETEMPTY(gen[i],xbits);
-				SETEMPTY(killed[i],xbits);
-				SETEMPTY(in[i],xbits);
-				SETEMPTY(out[i],xbits);
-			}
-			SETEMPTY(saved,xbits);
+		if (dce(p2e))
 			goto livagain;
-		}
 	}
 
 	DLIST_FOREACH(bb, &p2e->bblocks, bbelem) {
 		RDEBUG(("liveadd bb %d\n", bb->bbnum));
 		i = bb->bbnum;
-		for (j = 0; j < xbits; j += NUMBITS)
-			live[j/NUMBITS] = 0;
-		SETCOPY(live, out[i], j, xbits);
+		lsbits(live, &out[i], xbits);
 		for (ip = bb->last; ; ip = DLIST_PREV(ip, qelem)) {
 			if (ip->type == IP_NODE) {
 				if (ip->ip_node->n_op == XASM) {
@@ -1853,6 +1926,16 @@ livagain:
 			for (; w; w = w->next)
 				printf("%d <-> %d\n", ASGNUM(w->u), ASGNUM(w->v));
 		}
+		/* the bit matrix is not walkable, use the adjacency lists */
+		DLIST_FOREACH(y, &initial, link) {
+			if (adjmat == NULL)
+				break;
+			for (x = ADJLIST(y); x; x = x->r_next)
+				if (ONLIST(x->a_temp) == &precolored ||
+				    ASGNUM(y) < ASGNUM(x->a_temp))
+					printf("%d <-> %d\n", ASGNUM(y),
+					    ASGNUM(x->a_temp));
+		}
 		printf("Degrees\n");
 		DLIST_FOREACH(y, &initial, link) {
 			printf("%d (%c): trivial [%d] ", ASGNUM(y),
@@ -2324,10 +2407,111 @@ Freeze(void)
 	FreezeMoves(u);
 }
 
+#define	MAXSPDEPTH	4	/* deeper loops weigh the same */
+
+/*
+ * Return 1 if a temporary set to this value can be rematerialized.
+ */
+static int
+canremat(NODE *p)
+{
+	if (p->n_op == ICON)
+		return 1;
+	if (p->n_op == PLUS && p->n_left->n_op == REG &&
+	    regno(p->n_left) == FPREG && p->n_right->n_op == ICON)
+		return 1;
+	return 0;
+}
+
+static void
+spillwalk(NODE *p, void *arg)
+{
+	NODE *l;
+	int t;
+
+	if (p->n_op == TEMP)
+		l = p;
+	else if (p->n_op == ASSIGN || p->n_op == XARG)
+		l = p->n_left;
+	else
+		return;
+	if (l->n_op != TEMP)
+		return;
+	t = regno(l);
+	if (t < basetemp || t >= tempmax)
+		return;
+	if (p == l)
+		spcost[t] += spweight;
+	else if (p->n_op == ASSIGN)
+		spdefs[t]++;
+	else
+		spdefs[t] += 2; /* cannot be replaced in asm */
+}
+
+/*
+ * Count the uses of each long-lived temporary, weighted by 8 to the
+ * power of the loop depth of the block it is used in.  A temporary
+ * assigned only once, from a constant or a frame address, is saved
+ * in remat.
+ */
+static void
+spillcosts(struct p2env *p2e)
+{
+	struct basicblock *bb;
+	struct interpass *ip;
+	NODE *p;
+	int n = tempmax - tempmin;
+
+	spcost = tmpcalloc(n * sizeof(int));
+	spdefs = tmpcalloc(n * sizeof(int));
+	remat = tmpcalloc(n * sizeof(NODE *));
+	spcost -= tempmin;
+	spdefs -= tempmin;
+	remat -= tempmin;
+	if (xtemps == 0)
+		return;
+
+	DLIST_FOREACH(bb, &p2e->bblocks, bbelem) {
+		n = bb->loopdepth < MAXSPDEPTH ? bb->loopdepth : MAXSPDEPTH;
+		spweight = 1 << (3 * n);
+		for (ip = bb->first; ; ip = DLIST_NEXT(ip, qelem)) {
+			if (ip->type == IP_NODE) {
+				p = ip->ip_node;
+				walkf(p, spillwalk, 0);
+				if (p->n_op == ASSIGN && p->n_left->n_op == TEMP &&
+				    canremat(p->n_right))
+					remat[regno(p->n_left)] = p->n_right;
+			}
+			if (ip == bb->last)
+				break;
+		}
+	}
+	for (n = basetemp; n < tempmax; n++)
+		if (spdefs[n] != 1)
+			remat[n] = NULL;
+}
+
+/*
+ * Cost of spilling a long-lived temporary.  Those with many neighbours
+ * are cheaper, since spilling them helps more.
+ */
+static int
+spillcost(REGW *w)
+{
+	int c = spcost[w - nblock];
+	int i, n;
+
+	if (remat[w - nblock])
+		c /= 2;	/* no store needed */
+	for (n = 1, i = 1; i < NUMCLASS+1; i++)
+		n += NCLASS(w, i);
+	return c * 16 / n;
+}
+
 static void
 SelectSpill(void)
 {
-	REGW *w;
+	REGW *w, *v;
 
 	RDEBUG(("SelectSpill\n"));
 #ifdef PCC_DEBUG
@@ -2344,12 +2528,14 @@ SelectSpill(void)
 
 	RRDEBUG(("SelectSpill: trying longrange\n"));
 	if (w == &spillWorklist) {
-		/* try to find another long-range variable */
-		DLIST_FOREACH(w, &spillWorklist, link) {
-			if (innotspill(w - nblock))
+		/* try to find the cheapest long-range variable */
+		DLIST_FOREACH(v, &spillWorklist, link) {
+			if (innotspill(v - nblock))
 				continue;
-			if (w >= &nblock[tempmin] && w < &nblock[tempmax])
-				break;
+			if (v < &nblock[tempmin] || v >= &nblock[tempmax])
+				continue;
+			if (w == &spillWorklist || spillcost(v) < spillcost(w))
+				w = v;
 		}
 	}
 
@@ -2874,6 +3060,66 @@ temparg(struct interpass *ipole, REGW *w)
 	return 0;
 }
 
+/*
+ * Replace TEMPs in the spole list with a copy of their value.
+ */
+static void
+rematwalk(NODE *p, void *arg)
+{
+	NODE *q;
+	REGW *w;
+
+	if (p->n_op != TEMP)
+		return;
+	DLIST_FOREACH(w, spole, link) {
+		if (w != &nblock[regno(p)])
+			continue;
+		q = tcopy(remat[regno(p)]);
+		q->n_type = p->n_type;
+		*p = *q;
+		nfree(q);
+		break;
+	}
+}
+
+/*
+ * Rematerialize the temporaries in the rpole list.  Their only
+ * assignment is removed and each use gets the value instead.
+ */
+static void
+rematrewrite(struct interpass *ipole, REGW *rpole)
+{
+	struct interpass *ip;
+	REGW *w;
+	NODE *p;
+
+	DLIST_FOREACH(ip, ipole, qelem) {
+		if (ip->type != IP_NODE)
+			continue;
+		p = ip->ip_node;
+		if (p->n_op != ASSIGN || p->n_left->n_op != TEMP ||
+		    p->n_right != remat[regno(p->n_left)])
+			continue;
+		DLIST_FOREACH(w, rpole, link)
+			if (w == &nblock[regno(p->n_left)])
+				break;
+		if (w == rpole)
+			continue;
+		nfree(p->n_left);
+		nfree(p);
+		/* Cannot DLIST_REMOVE here, would break basic blocks */
+		ip->type = IP_ASM;
+		ip->ip_asm = "";
+	}
+	spole = rpole;
+	DLIST_FOREACH(ip, ipole, qelem)
+		if (ip->type == IP_NODE)
+			walkf(ip->ip_node, rematwalk, 0);
+	DLIST_FOREACH(w, rpole, link)
+		tfree(remat[w - nblock]);
+	spole = NULL;
+}
+
 #define	ONLYPERM 1
 #define	LEAVES	 2
 #define	SMALL	 3
@@ -2887,11 +3133,12 @@ temparg(struct interpass *ipole, REGW *w)
 static int
 RewriteProgram(struct interpass *ip)
 {
-	REGW shortregs, longregs, saveregs, *q;
+	REGW shortregs, longregs, saveregs, rematregs, *q;
 	REGW *w;
 	int rwtyp;
 
 	RDEBUG(("RewriteProgram\n"));
+	DLIST_INIT(&rematregs, link);
 	DLIST_INIT(&shortregs, link);
 	DLIST_INIT(&longregs, link);
 	DLIST_INIT(&saveregs, link);
@@ -2932,6 +3179,18 @@ RewriteProgram(struct interpass *ip)
 			nsavregs[num] = 1;
 		}
 	}
+	/* constants and frame addresses are recomputed instead */
+	for (w = DLIST_NEXT(&longregs, link); w != &longregs; w = q) {
+		q = DLIST_NEXT(w, link);
+		if (remat[w - nblock] == NULL)
+			continue;
+		DLIST_REMOVE(w, link);
+		DLIST_INSERT_AFTER(&rematregs, w, link);
+	}
+	if (!DLIST_ISEMPTY(&rematregs, link)) {
+		rematrewrite(ip, &rematregs);
+		rwtyp = ONLYPERM;
+	}
 	if (!DLIST_ISEMPTY(&longregs, link)) {
 		rwtyp = LEAVES;
 		DLIST_FOREACH(w, &longregs, link) {
@@ -3055,16 +3314,11 @@ ngenregs(struct p2env *p2e)
 		ablock[i].r_onlist = &precolored;
 		ablock[i].r_class = GCLASS(i); /* XXX */
 		ablock[i].r_color = i;
-#ifdef PCC_DEBUG
 		ablock[i].nodnum = i;
-#endif
 	}
 
 ssagain:
 	tempmax = p2e->epp->ip_tmpnum;
-#ifdef PCC_DEBUG
-	nodnum = tempmax;
-#endif
 	tbits = tempmax - tempmin;	/* # of temporaries */
 	xbits = tbits + MAXREGS;	/* total size of live array */
 	if (tbits) {
@@ -3085,7 +3339,6 @@ ssagain:
 
 recalc:
 onlyperm: /* XXX - should not have to redo all */
-	memset(edgehash, 0, sizeof(edgehash));
 
 	/* clear adjacent node list */
 	for (i = 0; i < MAXREGS; i++)
@@ -3094,11 +3347,10 @@ onlyperm: /* XXX - should not have to redo all */
 
 	if (tbits) {
 		memset(nblock+tempmin, 0, tbits * sizeof(REGW));
-#ifdef PCC_DEBUG
 		for (i = tempmin; i < tempmax; i++)
 			nblock[i].nodnum = i;
-#endif
 	}
+	nodnum = tempmax;	/* short-lived nodes numbered after temps */
 	memset(live, 0, BIT2BYTE(xbits));
 	RPRINTIP(ipole);
 	DLIST_INIT(&initial, link);
@@ -3117,8 +3369,11 @@ onlyperm: /* XXX - should not have to redo all */
 		walkf(ip->ip_node, traclass, 0);
 	}
 	nodepole = NIL;
+	if (tbits)
+		spillcosts(p2e);
 	RDEBUG(("nsucomp allocated %d temps (%d,%d)\n", 
 	    tempmax-tempmin, tempmin, tempmax));
+	adjinit();
 
 #ifdef PCC_DEBUG
 	use_regw = 1;
@@ -3145,7 +3400,8 @@ onlyperm: /* XXX - should not have to redo all */
 	}
 
 	Build(p2e);
-	RDEBUG(("Build done\n"));
+	RDEBUG(("Build done: %d nodes %d edges, %s, %d probes (longest %d)\n",
+	    adjnodes, nedges, adjmat ? "matrix" : "hash", nprobes, maxprobe));
 	MkWorklist();
 	RDEBUG(("MkWorklist done\n"));
 	Coalassign(p2e);
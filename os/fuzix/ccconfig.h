@@ -44,6 +44,7 @@
 
 #if defined(mach_tms9995)
 #define	CPPMDADD { "-D__tms99xx__", "-Dtms99xx", NULL, }
+#define	HAVE_CC2	/* peephole optimizer, run at -O */
 #else
 #error defines for arch missing
 #endif